@@ -1,33 +1,37 @@
 #include <Arduino.h>
 #include "DataStore.h"
 
-#if defined(EXTRAFS) || defined(QSPIFLASH)
-  #define MAX_BLOBRECS 100
-#else
-  #define MAX_BLOBRECS 20
-#endif
-
 DataStore::DataStore(FILESYSTEM& fs, mesh::RTCClock& clock) : _fs(&fs), _fsExtra(nullptr), _clock(&clock),
 #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
-    identity_store(fs, "")
+    identity_store(fs, ""),
 #elif defined(RP2040_PLATFORM)
-    identity_store(fs, "/identity")
+    identity_store(fs, "/identity"),
 #else
-    identity_store(fs, "/identity")
+    identity_store(fs, "/identity"),
 #endif
+    contacts_jnl(&fs, "/contacts4"), channels_jnl(&fs, "/channels3")
 {
+  _loading = false;
+#if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+  _num_blob_slots = -1;
+#endif
 }
 
 #if defined(EXTRAFS) || defined(QSPIFLASH)
 DataStore::DataStore(FILESYSTEM& fs, FILESYSTEM& fsExtra, mesh::RTCClock& clock) : _fs(&fs), _fsExtra(&fsExtra), _clock(&clock),
 #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
-    identity_store(fs, "")
+    identity_store(fs, ""),
 #elif defined(RP2040_PLATFORM)
-    identity_store(fs, "/identity")
+    identity_store(fs, "/identity"),
 #else
-    identity_store(fs, "/identity")
+    identity_store(fs, "/identity"),
 #endif
+    contacts_jnl(&fsExtra, "/contacts4"), channels_jnl(&fsExtra, "/channels3")
 {
+  _loading = false;
+#if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+  _num_blob_slots = -1;
+#endif
 }
 #endif
 
@@ -57,6 +61,7 @@ void DataStore::begin() {
   #if defined(EXTRAFS) || defined(QSPIFLASH)
   migrateToSecondaryFS();
   #endif
+  loadBlobDir();
 #else
   // init 'blob store' support
   _fs->mkdir("/bl");
@@ -280,68 +285,174 @@ void DataStore::savePrefs(const NodePrefs& _prefs, double node_lat, double node_
   }
 }
 
+// contacts and channels are journaled, see JournalStore
+#define REC_CONTACT         1
+#define REC_CONTACT_DEL     2
+#define REC_CHANNEL         3
+
+#define CONTACT_REC_SIZE   152   // same layout as a contact in old /contacts3 file
+#define CHANNEL_REC_SIZE    69   // channel_idx, then same layout as a channel in old /channels2 file
+
+static void writeContactRec(uint8_t* dest, const ContactInfo& c) {
+  int i = 0;
+  memcpy(&dest[i], c.id.pub_key, 32); i += 32;
+  memcpy(&dest[i], c.name, 32); i += 32;
+  dest[i++] = c.type;
+  dest[i++] = c.flags;
+  dest[i++] = 0;   // unused
+  memcpy(&dest[i], &c.sync_since, 4); i += 4;
+  dest[i++] = c.out_path_len;
+  memcpy(&dest[i], &c.last_advert_timestamp, 4); i += 4;
+  memcpy(&dest[i], c.out_path, 64); i += 64;
+  memcpy(&dest[i], &c.lastmod, 4); i += 4;
+  memcpy(&dest[i], &c.gps_lat, 4); i += 4;
+  memcpy(&dest[i], &c.gps_lon, 4); i += 4;
+}
+
+static void readContactRec(ContactInfo& c, const uint8_t* src) {
+  int i = 0;
+  c.id = mesh::Identity(&src[i]); i += 32;
+  memcpy(c.name, &src[i], 32); i += 32;
+  c.type = src[i++];
+  c.flags = src[i++];
+  i++;   // unused
+  memcpy(&c.sync_since, &src[i], 4); i += 4;   // was 'reserved'
+  c.out_path_len = src[i++];
+  memcpy(&c.last_advert_timestamp, &src[i], 4); i += 4;
+  memcpy(c.out_path, &src[i], 64); i += 64;
+  memcpy(&c.lastmod, &src[i], 4); i += 4;
+  memcpy(&c.gps_lat, &src[i], 4); i += 4;
+  memcpy(&c.gps_lon, &src[i], 4); i += 4;
+}
+
+static void writeChannelRec(uint8_t* dest, uint8_t channel_idx, const ChannelDetails& ch) {
+  dest[0] = channel_idx;
+  memset(&dest[1], 0, 4);   // unused
+  memcpy(&dest[5], ch.name, 32);
+  memcpy(&dest[37], ch.channel.secret, 32);
+}
+
+class ContactsLoader : public JournalVisitor {
+  DataStoreHost* _host;
+public:
+  ContactsLoader(DataStoreHost* host) : _host(host) { }
+
+  void onJournalRecord(uint8_t type, const uint8_t* data, int len) override {
+    if (type == REC_CONTACT && len == CONTACT_REC_SIZE) {
+      ContactInfo c;
+      readContactRec(c, data);
+      _host->onContactLoaded(c);    // NOTE: if full, keep going, as later records may be deletes
+    } else if (type == REC_CONTACT_DEL && len == PUB_KEY_SIZE) {
+      _host->onContactDeleted(data);
+    }
+  }
+};
+
+class ContactsSnapshot : public JournalSnapshotSource {
+  DataStoreHost* _host;
+public:
+  ContactsSnapshot(DataStoreHost* host) : _host(host) { }
+
+  bool writeSnapshot(JournalStore& store) override {
+    uint32_t idx = 0;
+    ContactInfo c;
+    uint8_t rec[CONTACT_REC_SIZE];
+    while (_host->getContactForSave(idx, c)) {
+      writeContactRec(rec, c);
+      if (!store.writeSnapshotRecord(REC_CONTACT, rec, sizeof(rec))) return false;
+      idx++;  // advance to next contact
+    }
+    return true;
+  }
+};
+
+class ChannelsLoader : public JournalVisitor {
+  DataStoreHost* _host;
+public:
+  ChannelsLoader(DataStoreHost* host) : _host(host) { }
+
+  void onJournalRecord(uint8_t type, const uint8_t* data, int len) override {
+    if (type == REC_CHANNEL && len == CHANNEL_REC_SIZE) {
+      ChannelDetails ch;
+      memcpy(ch.name, &data[5], 32);
+      memcpy(ch.channel.secret, &data[37], 32);
+      _host->onChannelLoaded(data[0], ch);
+    }
+  }
+};
+
+class ChannelsSnapshot : public JournalSnapshotSource {
+  DataStoreHost* _host;
+public:
+  ChannelsSnapshot(DataStoreHost* host) : _host(host) { }
+
+  bool writeSnapshot(JournalStore& store) override {
+    uint8_t channel_idx = 0;
+    ChannelDetails ch;
+    uint8_t rec[CHANNEL_REC_SIZE];
+    while (_host->getChannelForSave(channel_idx, ch)) {
+      writeChannelRec(rec, channel_idx, ch);
+      if (!store.writeSnapshotRecord(REC_CHANNEL, rec, sizeof(rec))) return false;
+      channel_idx++;
+    }
+    return true;
+  }
+};
+
 void DataStore::loadContacts(DataStoreHost* host) {
-File file = openRead(_getContactsChannelsFS(), "/contacts3");
+  ContactsLoader loader(host);
+  _loading = true;   // ignore any saves from host callbacks, while journal is being read
+  bool loaded = contacts_jnl.load(&loader);
+  if (!loaded) {
+    File file = openRead(_getContactsChannelsFS(), "/contacts3");   // from before journaling
     if (file) {
-      bool full = false;
-      while (!full) {
+      uint8_t rec[CONTACT_REC_SIZE];
+      while (file.read(rec, sizeof(rec)) == sizeof(rec)) {
         ContactInfo c;
-        uint8_t pub_key[32];
-        uint8_t unused;
-
-        bool success = (file.read(pub_key, 32) == 32);
-        success = success && (file.read((uint8_t *)&c.name, 32) == 32);
-        success = success && (file.read(&c.type, 1) == 1);
-        success = success && (file.read(&c.flags, 1) == 1);
-        success = success && (file.read(&unused, 1) == 1);
-        success = success && (file.read((uint8_t *)&c.sync_since, 4) == 4); // was 'reserved'
-        success = success && (file.read((uint8_t *)&c.out_path_len, 1) == 1);
-        success = success && (file.read((uint8_t *)&c.last_advert_timestamp, 4) == 4);
-        success = success && (file.read(c.out_path, 64) == 64);
-        success = success && (file.read((uint8_t *)&c.lastmod, 4) == 4);
-        success = success && (file.read((uint8_t *)&c.gps_lat, 4) == 4);
-        success = success && (file.read((uint8_t *)&c.gps_lon, 4) == 4);
-
-        if (!success) break; // EOF
-
-        c.id = mesh::Identity(pub_key);
-        if (!host->onContactLoaded(c)) full = true;
+        readContactRec(c, rec);
+        if (!host->onContactLoaded(c)) break;  // full
       }
       file.close();
+      loaded = true;
     }
+  }
+  _loading = false;
+
+  if (loaded && contacts_jnl.needsCompact()) {   // migrating from /contacts3, or journal ended with a torn record
+    saveContacts(host);
+    if (!contacts_jnl.needsCompact()) _getContactsChannelsFS()->remove("/contacts3");
+  }
 }
 
 void DataStore::saveContacts(DataStoreHost* host) {
-  File file = openWrite(_getContactsChannelsFS(), "/contacts3");
-  if (file) {
-    uint32_t idx = 0;
-    ContactInfo c;
-    uint8_t unused = 0;
-
-    while (host->getContactForSave(idx, c)) {
-      bool success = (file.write(c.id.pub_key, 32) == 32);
-      success = success && (file.write((uint8_t *)&c.name, 32) == 32);
-      success = success && (file.write(&c.type, 1) == 1);
-      success = success && (file.write(&c.flags, 1) == 1);
-      success = success && (file.write(&unused, 1) == 1);
-      success = success && (file.write((uint8_t *)&c.sync_since, 4) == 4);
-      success = success && (file.write((uint8_t *)&c.out_path_len, 1) == 1);
-      success = success && (file.write((uint8_t *)&c.last_advert_timestamp, 4) == 4);
-      success = success && (file.write(c.out_path, 64) == 64);
-      success = success && (file.write((uint8_t *)&c.lastmod, 4) == 4);
-      success = success && (file.write((uint8_t *)&c.gps_lat, 4) == 4);
-      success = success && (file.write((uint8_t *)&c.gps_lon, 4) == 4);
-
-      if (!success) break; // write failed
+  ContactsSnapshot snapshot(host);
+  contacts_jnl.compact(&snapshot);
+}
 
-      idx++;  // advance to next contact
-    }
-    file.close();
+void DataStore::saveContact(DataStoreHost* host, const ContactInfo& contact) {
+  if (_loading) return;
+
+  uint8_t rec[CONTACT_REC_SIZE];
+  writeContactRec(rec, contact);
+  if (contacts_jnl.needsCompact() || !contacts_jnl.append(REC_CONTACT, rec, sizeof(rec))) {
+    saveContacts(host);    // includes this contact
   }
 }
 
+void DataStore::deleteContact(DataStoreHost* host, const uint8_t* pub_key) {
+  if (_loading) return;
+
+  if (contacts_jnl.needsCompact()) {
+    saveContacts(host);    // NOTE: host may still have this contact (eg. about to be overwritten), so still append the delete
+  }
+  contacts_jnl.append(REC_CONTACT_DEL, pub_key, PUB_KEY_SIZE);   // if this fails, next save will compact
+}
+
 void DataStore::loadChannels(DataStoreHost* host) {
-    File file = openRead(_getContactsChannelsFS(), "/channels2");
+  ChannelsLoader loader(host);
+  bool loaded = channels_jnl.load(&loader);
+  if (!loaded) {
+    File file = openRead(_getContactsChannelsFS(), "/channels2");   // from before journaling
     if (file) {
       bool full = false;
       uint8_t channel_idx = 0;
@@ -362,26 +473,29 @@ void DataStore::loadChannels(DataStoreHost* host) {
         }
       }
       file.close();
+      loaded = true;
     }
+  }
+
+  if (loaded && channels_jnl.needsCompact()) {   // migrating from /channels2, or journal ended with a torn record
+    saveChannels(host);
+    if (!channels_jnl.needsCompact()) _getContactsChannelsFS()->remove("/channels2");
+  }
 }
 
 void DataStore::saveChannels(DataStoreHost* host) {
-  File file = openWrite(_getContactsChannelsFS(), "/channels2");
-  if (file) {
-    uint8_t channel_idx = 0;
-    ChannelDetails ch;
-    uint8_t unused[4];
-    memset(unused, 0, 4);
+  ChannelsSnapshot snapshot(host);
+  channels_jnl.compact(&snapshot);
+}
 
-    while (host->getChannelForSave(channel_idx, ch)) {
-      bool success = (file.write(unused, 4) == 4);
-      success = success && (file.write((uint8_t *)ch.name, 32) == 32);
-      success = success && (file.write((uint8_t *)ch.channel.secret, 32) == 32);
+void DataStore::saveChannel(DataStoreHost* host, uint8_t channel_idx) {
+  ChannelDetails ch;
+  if (!host->getChannelForSave(channel_idx, ch)) return;
 
-      if (!success) break; // write failed
-      channel_idx++;
-    }
-    file.close();
+  uint8_t rec[CHANNEL_REC_SIZE];
+  writeChannelRec(rec, channel_idx, ch);
+  if (channels_jnl.needsCompact() || !channels_jnl.append(REC_CHANNEL, rec, sizeof(rec))) {
+    saveChannels(host);
   }
 }
 
@@ -407,9 +521,35 @@ void DataStore::checkAdvBlobFile() {
       }
       file.close();
     }
+    _num_blob_slots = -1;   // directory is stale (eg. file was removed by 'rm' command)
+  }
+}
+
+void DataStore::loadBlobDir() {
+  _num_blob_slots = 0;
+  File file = openRead(_getContactsChannelsFS(), "/adv_blobs");
+  if (file) {
+    int n = file.size() / sizeof(BlobRec);
+    if (n > MAX_BLOBRECS) n = MAX_BLOBRECS;
+
+    // just read the timestamp and key of each record
+    while (_num_blob_slots < n) {
+      BlobDirEntry* e = &_blob_dir[_num_blob_slots];
+      file.seek(_num_blob_slots * sizeof(BlobRec));
+      if (file.read((uint8_t *) &e->timestamp, 4) != 4 || file.read(e->key, sizeof(e->key)) != sizeof(e->key)) break;
+      _num_blob_slots++;
+    }
+    file.close();
   }
 }
 
+int DataStore::findBlobSlot(const uint8_t key[]) const {
+  for (int i = 0; i < _num_blob_slots; i++) {
+    if (memcmp(key, _blob_dir[i].key, sizeof(_blob_dir[i].key)) == 0) return i;  // only match by 7 byte prefix
+  }
+  return -1;  // not found
+}
+
 void DataStore::migrateToSecondaryFS() {
   // migrate old adv_blobs, contacts3 and channels2 files to secondary FS if they don't already exist
   if (!_fsExtra->exists("/adv_blobs")) {
@@ -519,16 +659,19 @@ void DataStore::migrateToSecondaryFS() {
 }
 
 uint8_t DataStore::getBlobByKey(const uint8_t key[], int key_len, uint8_t dest_buf[]) {
+  if (_num_blob_slots < 0) loadBlobDir();
+
+  int i = findBlobSlot(key);
+  if (i < 0) return 0;  // not found
+
   File file = openRead(_getContactsChannelsFS(), "/adv_blobs");
-  uint8_t len = 0;  // 0 = not found
+  uint8_t len = 0;
   if (file) {
     BlobRec tmp;
-    while (file.read((uint8_t *) &tmp, sizeof(tmp)) == sizeof(tmp)) {
-      if (memcmp(key, tmp.key, sizeof(tmp.key)) == 0) {  // only match by 7 byte prefix
-        len = tmp.len;
-        memcpy(dest_buf, tmp.data, len);
-        break;
-      }
+    file.seek(i * sizeof(BlobRec));
+    if (file.read((uint8_t *) &tmp, sizeof(tmp)) == sizeof(tmp) && memcmp(key, tmp.key, sizeof(tmp.key)) == 0) {  // check, in case file changed underneath
+      len = tmp.len;
+      memcpy(dest_buf, tmp.data, len);
     }
     file.close();
   }
@@ -538,42 +681,67 @@ uint8_t DataStore::getBlobByKey(const uint8_t key[], int key_len, uint8_t dest_b
 bool DataStore::putBlobByKey(const uint8_t key[], int key_len, const uint8_t src_buf[], uint8_t len) {
   if (len < PUB_KEY_SIZE+4+SIGNATURE_SIZE || len > MAX_ADVERT_PKT_LEN) return false;
   checkAdvBlobFile();
-  File file = _getContactsChannelsFS()->open("/adv_blobs", FILE_O_WRITE);
-  if (file) {
-    uint32_t pos = 0, found_pos = 0;
-    uint32_t min_timestamp = 0xFFFFFFFF;
+  if (_num_blob_slots < 0) loadBlobDir();
 
-    // search for matching key OR evict by oldest timestmap
-    BlobRec tmp;
-    file.seek(0);
-    while (file.read((uint8_t *) &tmp, sizeof(tmp)) == sizeof(tmp)) {
-      if (memcmp(key, tmp.key, sizeof(tmp.key)) == 0) {  // only match by 7 byte prefix
-        found_pos = pos;
-        break;
-      }
-      if (tmp.timestamp < min_timestamp) {
-        min_timestamp = tmp.timestamp;
-        found_pos = pos;
+  // find matching key OR evict by oldest timestamp
+  int i = findBlobSlot(key);
+  if (i < 0) {
+    uint32_t min_timestamp = 0xFFFFFFFF;
+    i = 0;
+    for (int j = 0; j < _num_blob_slots; j++) {
+      if (_blob_dir[j].timestamp < min_timestamp) {
+        min_timestamp = _blob_dir[j].timestamp;
+        i = j;
       }
-
-      pos += sizeof(tmp);
     }
+  }
 
+  File file = _getContactsChannelsFS()->open("/adv_blobs", FILE_O_WRITE);
+  if (file) {
+    BlobRec tmp;
     memcpy(tmp.key, key, sizeof(tmp.key));  // just record 7 byte prefix of key
     memcpy(tmp.data, src_buf, len);
     tmp.len = len;
     tmp.timestamp = _clock->getCurrentTime();
 
-    file.seek(found_pos);
-    file.write((uint8_t *) &tmp, sizeof(tmp));
-
+    file.seek(i * sizeof(BlobRec));
+    bool success = (file.write((uint8_t *) &tmp, sizeof(tmp)) == sizeof(tmp));
     file.close();
-    return true;
+
+    if (success) {
+      _blob_dir[i].timestamp = tmp.timestamp;
+      memcpy(_blob_dir[i].key, tmp.key, sizeof(tmp.key));
+      if (i >= _num_blob_slots) _num_blob_slots = i + 1;
+    } else {
+      _num_blob_slots = -1;   // not sure what's in file now, reload directory
+    }
+    return success;
   }
   return false; // error
 }
+
 bool DataStore::deleteBlobByKey(const uint8_t key[], int key_len) {
-  return true; // this is just a stub on NRF52/STM32 platforms
+  checkAdvBlobFile();
+  if (_num_blob_slots < 0) loadBlobDir();
+
+  int i = findBlobSlot(key);
+  if (i >= 0) {   // zero the record, so slot is first to be re-used
+    File file = _getContactsChannelsFS()->open("/adv_blobs", FILE_O_WRITE);
+    if (file) {
+      BlobRec zeroes;
+      memset(&zeroes, 0, sizeof(zeroes));
+      file.seek(i * sizeof(BlobRec));
+      bool success = (file.write((uint8_t *) &zeroes, sizeof(zeroes)) == sizeof(zeroes));
+      file.close();
+
+      if (success) {
+        memset(&_blob_dir[i], 0, sizeof(_blob_dir[i]));
+      } else {
+        _num_blob_slots = -1;
+      }
+    }
+  }
+  return true; // return true even if not found
 }
 #else
 inline void makeBlobPath(const uint8_t key[], int key_len, char* path, size_t path_size) {
@@ -1,13 +1,25 @@
 #pragma once
 
 #include <helpers/IdentityStore.h>
+#include <helpers/JournalStore.h>
 #include <helpers/ContactInfo.h>
 #include <helpers/ChannelDetails.h>
 #include "NodePrefs.h"
 
+#if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+  #ifndef MAX_BLOBRECS
+    #if defined(EXTRAFS) || defined(QSPIFLASH)
+      #define MAX_BLOBRECS 100
+    #else
+      #define MAX_BLOBRECS 20
+    #endif
+  #endif
+#endif
+
 class DataStoreHost {
 public:
-  virtual bool onContactLoaded(const ContactInfo& contact) =0;
+  virtual bool onContactLoaded(const ContactInfo& contact) =0;   // NOTE: replaces any contact with same pub_key
+  virtual void onContactDeleted(const uint8_t* pub_key) =0;
   virtual bool getContactForSave(uint32_t idx, ContactInfo& contact) =0;
   virtual bool onChannelLoaded(uint8_t channel_idx, const ChannelDetails& ch) =0;
   virtual bool getChannelForSave(uint8_t channel_idx, ChannelDetails& ch) =0;
@@ -18,10 +30,21 @@ class DataStore {
   FILESYSTEM* _fsExtra;
   mesh::RTCClock* _clock;
   IdentityStore identity_store;
+  JournalStore contacts_jnl, channels_jnl;
+  bool _loading;
 
   void loadPrefsInt(const char *filename, NodePrefs& prefs, double& node_lat, double& node_lon);
 #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+  struct BlobDirEntry {     // RAM copy of an /adv_blobs record's header, so get/put only need to access that one record
+    uint32_t timestamp;
+    uint8_t  key[7];
+  };
+  BlobDirEntry _blob_dir[MAX_BLOBRECS];
+  int _num_blob_slots;      // -1 = needs (re)loading from file
+
   void checkAdvBlobFile();
+  void loadBlobDir();
+  int findBlobSlot(const uint8_t key[]) const;
 #endif
 
 public:
@@ -36,9 +59,12 @@ public:
   void loadPrefs(NodePrefs& prefs, double& node_lat, double& node_lon);
   void savePrefs(const NodePrefs& prefs, double node_lat, double node_lon);
   void loadContacts(DataStoreHost* host);
-  void saveContacts(DataStoreHost* host);
+  void saveContacts(DataStoreHost* host);    // writes all contacts
+  void saveContact(DataStoreHost* host, const ContactInfo& contact);   // just one (new or changed) contact
+  void deleteContact(DataStoreHost* host, const uint8_t* pub_key);
   void loadChannels(DataStoreHost* host);
-  void saveChannels(DataStoreHost* host);
+  void saveChannels(DataStoreHost* host);    // writes all channels
+  void saveChannel(DataStoreHost* host, uint8_t channel_idx);
   void migrateToSecondaryFS();
   uint8_t getBlobByKey(const uint8_t key[], int key_len, uint8_t dest_buf[]);
   bool putBlobByKey(const uint8_t key[], int key_len, const uint8_t src_buf[], uint8_t len);
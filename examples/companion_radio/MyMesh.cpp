@@ -84,6 +84,7 @@
 #define STATS_TYPE_CORE               0
 #define STATS_TYPE_RADIO              1
 #define STATS_TYPE_PACKETS             2
+#define STATS_TYPE_LATENCY             3
 
 #define RESP_CODE_OK                  0
 #define RESP_CODE_ERR                 1
@@ -285,7 +286,7 @@ int MyMesh::getInterferenceThreshold() const {
 
 int MyMesh::calcRxDelay(float score, uint32_t air_time) const {
   if (_prefs.rx_delay_base <= 0.0f) return 0;
-  return (int)((pow(_prefs.rx_delay_base, 0.85f - score) - 1.0) * air_time);
+  return calcScoreDelay(_prefs.rx_delay_base, score, air_time);
 }
 
 uint32_t MyMesh::getRetransmitDelay(const mesh::Packet *packet) {
@@ -412,6 +413,7 @@ uint8_t MyMesh::getAutoAddMaxHops() const {
 
 void MyMesh::onContactOverwrite(const uint8_t* pub_key) {
     _store->deleteBlobByKey(pub_key, PUB_KEY_SIZE); // delete from storage
+    _store->deleteContact(this, pub_key);
   if (_serial->isConnected()) {
     out_frame[0] = PUSH_CODE_CONTACT_DELETED;
     memcpy(&out_frame[1], pub_key, PUB_KEY_SIZE);
@@ -419,6 +421,34 @@ void MyMesh::onContactOverwrite(const uint8_t* pub_key) {
   }
 }
 
+void MyMesh::markContactDirty(const ContactInfo& contact) {
+  if (num_dirty_contacts >= 0) {
+    int i = 0;
+    while (i < num_dirty_contacts && memcmp(dirty_contacts[i], contact.id.pub_key, PUB_KEY_SIZE) != 0) i++;
+    if (i == num_dirty_contacts) {   // not already dirty
+      if (num_dirty_contacts < MAX_DIRTY_CONTACTS) {
+        memcpy(dirty_contacts[num_dirty_contacts++], contact.id.pub_key, PUB_KEY_SIZE);
+      } else {
+        num_dirty_contacts = -1;   // too many, just write them all
+      }
+    }
+  }
+  dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
+}
+
+void MyMesh::saveDirtyContacts() {
+  if (num_dirty_contacts < 0) {
+    saveContacts();
+  } else {
+    for (int i = 0; i < num_dirty_contacts; i++) {
+      ContactInfo* c = lookupContactByPubKey(dirty_contacts[i], PUB_KEY_SIZE);
+      if (c) _store->saveContact(this, *c);   // NOTE: may have been removed since
+    }
+  }
+  num_dirty_contacts = 0;
+  dirty_contacts_expiry = 0;
+}
+
 void MyMesh::onContactsFull() {
   if (_serial->isConnected()) {
     out_frame[0] = PUSH_CODE_CONTACTS_FULL;
@@ -462,7 +492,7 @@ void MyMesh::onDiscoveredContact(ContactInfo &contact, bool is_new, uint8_t path
     p->path_len = mesh::Packet::copyPath(p->path, path, path_len);
   }
 
-  if (!is_new) dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY); // only schedule lazy write for contacts that are in contacts[]
+  if (!is_new) markContactDirty(contact); // only schedule lazy write for contacts that are in contacts[]
 }
 
 static int sort_by_recent(const void *a, const void *b) {
@@ -561,7 +591,7 @@ void MyMesh::onContactPathUpdated(const ContactInfo &contact) {
   memcpy(&out_frame[1], contact.id.pub_key, PUB_KEY_SIZE);
   _serial->writeFrame(out_frame, 1 + PUB_KEY_SIZE); // NOTE: app may not be connected
 
-  dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
+  markContactDirty(contact);
 
   if (_ui) {
     _ui->onPathUpdated(contact, (int16_t)_radio->getLastRSSI(), (int8_t)(_radio->getLastSNR() * 4));
@@ -712,7 +742,7 @@ void MyMesh::onSignedMessageRecv(const ContactInfo &from, mesh::Packet *pkt, uin
                                  const uint8_t *sender_prefix, const char *text) {
   markConnectionActive(from);
   // from.sync_since change needs to be persisted
-  dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
+  markContactDirty(from);
   queueMessage(from, TXT_TYPE_SIGNED_PLAIN, pkt, sender_timestamp, sender_prefix, 4, text);
 }
 
@@ -1239,7 +1269,7 @@ bool MyMesh::shouldNotifyForContact(const uint8_t* pub_key, const char* text) co
 }
 
 MyMesh::MyMesh(mesh::Radio &radio, mesh::RNG &rng, mesh::RTCClock &rtc, SimpleMeshTables &tables, DataStore& store, AbstractUITask* ui)
-    : BaseChatMesh(radio, *new ArduinoMillis(), rng, rtc, *new StaticPoolPacketManager(16), tables),
+    : BaseChatMesh(radio, *new ArduinoMillis(), rng, rtc, *new HeapPacketManager(16), tables),
       _serial(NULL), telemetry(MAX_PACKET_PAYLOAD - 4), _store(&store), _ui(ui) {
   _iter_started = false;
   _cli_rescue = false;
@@ -1250,6 +1280,7 @@ MyMesh::MyMesh(mesh::Radio &radio, mesh::RNG &rng, mesh::RTCClock &rtc, SimpleMe
   next_ack_idx = 0;
   sign_data = NULL;
   dirty_contacts_expiry = 0;
+  num_dirty_contacts = 0;
   memset(advert_paths, 0, sizeof(advert_paths));
   memset(send_scope.key, 0, sizeof(send_scope.key));
   memset(_last_sent_hash, 0, sizeof(_last_sent_hash));
@@ -1657,7 +1688,7 @@ void MyMesh::handleCmdFrame(size_t len) {
     if (recipient) {
       recipient->out_path_len = OUT_PATH_UNKNOWN;
       // recipient->lastmod = ??   shouldn't be needed, app already has this version of contact
-      dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
+      markContactDirty(*recipient);
       writeOKFrame();
     } else {
       writeErrFrame(ERR_CODE_NOT_FOUND); // unknown contact
@@ -1668,8 +1699,8 @@ void MyMesh::handleCmdFrame(size_t len) {
     uint32_t last_mod = getRTCClock()->getCurrentTime();  // fallback value if not present in cmd_frame
     if (recipient) {
       updateContactFromFrame(*recipient, last_mod, cmd_frame, len);
-      recipient->lastmod = last_mod;
-      dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
+      touchContact(*recipient, last_mod);   // NOTE: keeps recent list in lastmod order
+      markContactDirty(*recipient);
       writeOKFrame();
     } else {
       ContactInfo contact;
@@ -1677,7 +1708,7 @@ void MyMesh::handleCmdFrame(size_t len) {
       contact.lastmod = last_mod;
       contact.sync_since = 0;
       if (addContact(contact)) {
-        dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
+        markContactDirty(contact);
         writeOKFrame();
       } else {
         writeErrFrame(ERR_CODE_TABLE_FULL);
@@ -1688,7 +1719,7 @@ void MyMesh::handleCmdFrame(size_t len) {
     ContactInfo *recipient = lookupContactByPubKey(pub_key, PUB_KEY_SIZE);
     if (recipient && removeContact(*recipient)) {
       _store->deleteBlobByKey(pub_key, PUB_KEY_SIZE);
-      dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
+      _store->deleteContact(this, pub_key);
       writeOKFrame();
     } else {
       writeErrFrame(ERR_CODE_NOT_FOUND); // not found, or unable to remove
@@ -1850,7 +1881,7 @@ void MyMesh::handleCmdFrame(size_t len) {
     }
   } else if (cmd_frame[0] == CMD_REBOOT && memcmp(&cmd_frame[1], "reboot", 6) == 0) {
     if (dirty_contacts_expiry) { // is there are pending dirty contacts write needed?
-      saveContacts();
+      saveDirtyContacts();
     }
     board.reboot();
   } else if (cmd_frame[0] == CMD_GET_BATT_AND_STORAGE) {
@@ -2093,7 +2124,7 @@ void MyMesh::handleCmdFrame(size_t len) {
     memset(channel.channel.secret, 0, sizeof(channel.channel.secret));
     memcpy(channel.channel.secret, &cmd_frame[2 + 32], 16); // NOTE: only 128-bit supported
     if (setChannel(channel_idx, channel)) {
-      saveChannels();
+      _store->saveChannel(this, channel_idx);
       writeOKFrame();
     } else {
       writeErrFrame(ERR_CODE_NOT_FOUND); // bad channel_idx
@@ -2259,6 +2290,8 @@ void MyMesh::handleCmdFrame(size_t len) {
       out_frame[i++] = last_snr;
       memcpy(&out_frame[i], &tx_air_secs, 4); i += 4;
       memcpy(&out_frame[i], &rx_air_secs, 4); i += 4;
+      uint16_t chan_util = getChannelUtilisation(8000);   // permille
+      memcpy(&out_frame[i], &chan_util, 2); i += 2;
       _serial->writeFrame(out_frame, i);
     } else if (stats_type == STATS_TYPE_PACKETS) {
       int i = 0;
@@ -2279,6 +2312,26 @@ void MyMesh::handleCmdFrame(size_t len) {
       memcpy(&out_frame[i], &n_recv_direct, 4); i += 4;
       memcpy(&out_frame[i], &n_recv_errors, 4); i += 4;
       _serial->writeFrame(out_frame, i);
+    } else if (stats_type == STATS_TYPE_LATENCY && len >= 3) {
+#if MESH_LATENCY_STATS
+      const mesh::LatencyHistogram* h = getLatencyStats().getByIdx(cmd_frame[2]);
+      if (h) {
+        int i = 0;
+        out_frame[i++] = RESP_CODE_STATS;
+        out_frame[i++] = STATS_TYPE_LATENCY;
+        out_frame[i++] = cmd_frame[2];   // index
+        out_frame[i++] = getLatencyStats().getCount();
+        out_frame[i++] = h->stage;
+        out_frame[i++] = h->key;
+        memcpy(&out_frame[i], &h->total, 4); i += 4;
+        memcpy(&out_frame[i], h->counts, sizeof(h->counts)); i += sizeof(h->counts);
+        _serial->writeFrame(out_frame, i);
+      } else {
+        writeErrFrame(ERR_CODE_NOT_FOUND); // index past last histogram
+      }
+#else
+      writeErrFrame(ERR_CODE_UNSUPPORTED_CMD); // not compiled in
+#endif
     } else {
       writeErrFrame(ERR_CODE_ILLEGAL_ARG); // invalid stats sub-type
     }
@@ -2645,8 +2698,7 @@ void MyMesh::loop() {
 
   // is there are pending dirty contacts write needed?
   if (dirty_contacts_expiry && millisHasNowPassed(dirty_contacts_expiry)) {
-    saveContacts();
-    dirty_contacts_expiry = 0;
+    saveDirtyContacts();
   }
 
 #ifdef DISPLAY_CLASS
@@ -31,7 +31,7 @@
 #include <helpers/BaseSerialInterface.h>
 #include <helpers/IdentityStore.h>
 #include <helpers/SimpleMeshTables.h>
-#include <helpers/StaticPoolPacketManager.h>
+#include <helpers/HeapPacketManager.h>
 #include <target.h>
 
 /* ---------------------------------- CONFIGURATION ------------------------------------- */
@@ -63,6 +63,10 @@
 #define OFFLINE_QUEUE_SIZE 16
 #endif
 
+#ifndef MAX_DIRTY_CONTACTS
+#define MAX_DIRTY_CONTACTS 8   // changed contacts to append to journal, before just writing them all
+#endif
+
 #ifndef BLE_NAME_PREFIX
 #define BLE_NAME_PREFIX "MeshCore-"
 #endif
@@ -164,6 +168,10 @@ protected:
 
   // DataStoreHost methods
   bool onContactLoaded(const ContactInfo& contact) override { return addContact(contact); }
+  void onContactDeleted(const uint8_t* pub_key) override {
+    ContactInfo* c = lookupContactByPubKey(pub_key, PUB_KEY_SIZE);
+    if (c) removeContact(*c);
+  }
   bool getContactForSave(uint32_t idx, ContactInfo& contact) override { return getContactByIdx(idx, contact); }
   bool onChannelLoaded(uint8_t channel_idx, const ChannelDetails& ch) override { return setChannel(channel_idx, ch); }
   bool getChannelForSave(uint8_t channel_idx, ChannelDetails& ch) override { return getChannel(channel_idx, ch); }
@@ -240,6 +248,8 @@ private:
   // helpers, short-cuts
   void saveChannels() { _store->saveChannels(this); }
   void saveContacts() { _store->saveContacts(this); }
+  void markContactDirty(const ContactInfo& contact);
+  void saveDirtyContacts();
 
   DataStore* _store;
   NodePrefs _prefs;
@@ -266,6 +276,8 @@ private:
   uint8_t *sign_data;
   uint32_t sign_data_len;
   unsigned long dirty_contacts_expiry;
+  uint8_t dirty_contacts[MAX_DIRTY_CONTACTS][PUB_KEY_SIZE];
+  int num_dirty_contacts;    // -1 = too many, save all
 
   TransportKey send_scope;
   uint8_t _last_sent_hash[MAX_HASH_SIZE];
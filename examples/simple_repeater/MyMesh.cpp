@@ -41,6 +41,13 @@
   #define TXT_ACK_DELAY 200
 #endif
 
+#ifdef WITH_SLAB_PACKET_POOL
+  // 6 working Packets + 52 small/11 large queue slabs: about the RAM of 32 full Packets, but ~2x in-flight
+  #define NEW_PACKET_MANAGER(ms)  new SlabPacketManager(6, 52, 11, &ms)
+#else
+  #define NEW_PACKET_MANAGER(ms)  new FairPacketManager(32, &ms)
+#endif
+
 #define FIRMWARE_VER_LEVEL       2
 
 #define REQ_TYPE_GET_STATUS         0x01 // same as _GET_STATS
@@ -83,10 +90,41 @@ void MyMesh::putNeighbour(const mesh::Identity &id, uint32_t timestamp, float sn
   neighbour->id = id;
   neighbour->advert_timestamp = timestamp;
   neighbour->heard_timestamp = getRTCClock()->getCurrentTime();
+  neighbour->relay_timestamp = 0;
   neighbour->snr = (int8_t)(snr * 4);
 #endif
 }
 
+void MyMesh::touchRelayNeighbour(const mesh::Packet* pkt) {
+#if MAX_NEIGHBOURS
+  int n = pkt->getPathHashCount();
+  if (n == 0) return;   // from the originator, not relayed
+
+  // the last hash in the path is the repeater which was just heard
+  uint8_t sz = pkt->getPathHashSize();
+  const uint8_t* hash = &pkt->path[(n - 1) * sz];
+  for (int i = 0; i < MAX_NEIGHBOURS; i++) {
+    if (neighbours[i].heard_timestamp && neighbours[i].id.isHashMatch(hash, sz)) {
+      neighbours[i].relay_timestamp = getRTCClock()->getCurrentTime();
+    }
+  }
+#endif
+}
+
+int MyMesh::countLiveNeighbours() {
+  int n = 0;
+#if MAX_NEIGHBOURS
+  uint32_t now = getRTCClock()->getCurrentTime();
+  for (int i = 0; i < MAX_NEIGHBOURS; i++) {
+    auto nb = &neighbours[i];
+    if (nb->heard_timestamp == 0) continue;   // unused
+    uint32_t last = nb->relay_timestamp > nb->heard_timestamp ? nb->relay_timestamp : nb->heard_timestamp;
+    if (now - last < LIVE_NEIGHBOUR_SECS) n++;
+  }
+#endif
+  return n;
+}
+
 uint8_t MyMesh::handleLoginReq(const mesh::Identity& sender, const uint8_t* secret, uint32_t sender_timestamp, const uint8_t* data, bool is_flood) {
   ClientInfo* client = NULL;
   if (data[0] == 0) {   // blank password, just check if sender is in ACL
@@ -232,8 +270,8 @@ int MyMesh::handleRequest(ClientInfo *sender, uint32_t sender_timestamp, uint8_t
     stats.n_recv_direct = getNumRecvDirect();
     stats.err_events = _err_flags;
     stats.last_snr = (int16_t)(radio_driver.getLastSNR() * 4);
-    stats.n_direct_dups = ((SimpleMeshTables *)getTables())->getNumDirectDups();
-    stats.n_flood_dups = ((SimpleMeshTables *)getTables())->getNumFloodDups();
+    stats.n_direct_dups = ((HashedMeshTables *)getTables())->getNumDirectDups();
+    stats.n_flood_dups = ((HashedMeshTables *)getTables())->getNumFloodDups();
     stats.total_rx_air_time_secs = getReceiveAirTime() / 1000;
     stats.n_recv_errors = radio_driver.getPacketsRecvErrors();
     memcpy(&reply_data[4], &stats, sizeof(stats));
@@ -533,12 +571,16 @@ void MyMesh::logTxFail(mesh::Packet *pkt, int len) {
 
 int MyMesh::calcRxDelay(float score, uint32_t air_time) const {
   if (_prefs.rx_delay_base <= 0.0f) return 0;
-  return (int)((pow(_prefs.rx_delay_base, 0.85f - score) - 1.0) * air_time);
+  return calcScoreDelay(_prefs.rx_delay_base, score, air_time);
 }
 
 uint32_t MyMesh::getRetransmitDelay(const mesh::Packet *packet) {
   uint32_t t = (_radio->getEstAirtimeFor(packet->getPathByteLen() + packet->payload_len + 2) * _prefs.tx_delay_factor);
-  return getRNG()->nextInt(0, 5*t + 1);
+  if (_prefs.flood_delay_mode == FLOOD_DELAY_ADAPTIVE && packet->getPathHashCount() > 0) {   // ie. is a relay, with an SNR
+    float margin = FloodDelayPolicy::calcSNRMargin(packet->getSNR(), radio_sf);
+    return adaptive_delay.getDelay(*getRNG(), t, margin, countLiveNeighbours());
+  }
+  return fixed_delay.getDelay(*getRNG(), t, 0, 0);
 }
 uint32_t MyMesh::getDirectRetransmitDelay(const mesh::Packet *packet) {
   uint32_t t = (_radio->getEstAirtimeFor(packet->getPathByteLen() + packet->payload_len + 2) * _prefs.direct_tx_delay_factor);
@@ -546,6 +588,8 @@ uint32_t MyMesh::getDirectRetransmitDelay(const mesh::Packet *packet) {
 }
 
 bool MyMesh::filterRecvFloodPacket(mesh::Packet* pkt) {
+  touchRelayNeighbour(pkt);   // NOTE: duplicates too, they still show the neighbour is active
+
   // just try to determine region for packet (apply later in allowPacketForward())
   if (pkt->getRouteType() == ROUTE_TYPE_TRANSPORT_FLOOD) {
     recv_pkt_region = region_map.findMatch(pkt, REGION_DENY_FLOOD);
@@ -843,12 +887,13 @@ void MyMesh::sendNodeDiscoverReq() {
 
 MyMesh::MyMesh(mesh::MainBoard &board, mesh::Radio &radio, mesh::MillisecondClock &ms, mesh::RNG &rng,
                mesh::RTCClock &rtc, mesh::MeshTables &tables)
-    : mesh::Mesh(radio, ms, rng, rtc, *new StaticPoolPacketManager(32), tables),
+    : mesh::Mesh(radio, ms, rng, rtc, *NEW_PACKET_MANAGER(ms), tables),
       region_map(key_store), temp_map(key_store),
       _cli(board, rtc, sensors, region_map, acl, &_prefs, this),
       telemetry(MAX_PACKET_PAYLOAD - 4),
       discover_limiter(4, 120),  // max 4 every 2 minutes
-      anon_limiter(4, 180)   // max 4 every 3 minutes
+      anon_limiter(4, 180),   // max 4 every 3 minutes
+      duty_ledger(EU868_DUTY_CYCLE_BANDS, NUM_EU868_DUTY_CYCLE_BANDS)
 #if defined(WITH_RS232_BRIDGE)
       , bridge(&_prefs, WITH_RS232_BRIDGE, _mgr, &rtc)
 #endif
@@ -860,7 +905,12 @@ MyMesh::MyMesh(mesh::MainBoard &board, mesh::Radio &radio, mesh::MillisecondCloc
   uptime_millis = 0;
   next_local_advert = next_flood_advert = 0;
   dirty_contacts_expiry = 0;
+  _warm = NULL;
+  next_warm_sync = 0;
   set_radio_at = revert_radio_at = 0;
+  duty_band = -1;
+  radio_freq = 0;
+  radio_sf = 0;
   _logging = false;
   region_load_active = false;
 
@@ -918,14 +968,16 @@ MyMesh::MyMesh(mesh::MainBoard &board, mesh::Radio &radio, mesh::MillisecondCloc
   memset(default_scope.key, 0, sizeof(default_scope.key));
 }
 
-void MyMesh::begin(FILESYSTEM *fs) {
+void MyMesh::begin(FILESYSTEM *fs, WarmState* warm) {
   mesh::Mesh::begin();
   _fs = fs;
+  _warm = warm;
   // load persisted prefs
   _cli.loadPrefs(_fs);
-  acl.load(_fs, self_id);
+  acl.load(_fs, self_id, getSharedSecretCache());
   // TODO: key_store.begin();
   region_map.load(_fs);
+  restoreWarmState();
 
   // establish default-scope
   {
@@ -955,11 +1007,16 @@ void MyMesh::begin(FILESYSTEM *fs) {
 
   radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
   radio_set_tx_power(_prefs.tx_power_dbm);
+  radio_freq = _prefs.freq;
+  radio_sf = _prefs.sf;
+  setDutyCycleBands(_prefs.duty_cycle_bands);
 
   radio_driver.setRxBoostedGainMode(_prefs.rx_boosted_gain);
   MESH_DEBUG_PRINTLN("RX Boosted Gain Mode: %s",
                      radio_driver.getRxBoostedGainMode() ? "Enabled" : "Disabled");
 
+  _mgr->setTxClassWeights(_prefs.tx_class_weights);
+
   updateAdvertTimer();
   updateFloodAdvertTimer();
 
@@ -1053,6 +1110,23 @@ void MyMesh::setTxPower(int8_t power_dbm) {
   radio_set_tx_power(power_dbm);
 }
 
+bool MyMesh::setTxClassWeights(const uint8_t weights[]) {
+  return _mgr->setTxClassWeights(weights);
+}
+
+bool MyMesh::setFloodSuppress(uint8_t threshold, bool snr_weighted) {
+  return true;   // NOTE: getFloodSuppressThreshold() reads the prefs
+}
+
+bool MyMesh::setFloodDelayMode(uint8_t mode) {
+  return true;   // NOTE: getRetransmitDelay() reads the prefs
+}
+
+bool MyMesh::setDutyCycleBands(bool enable) {
+  duty_band = enable ? duty_ledger.findBand(radio_freq) : -1;
+  return true;
+}
+
 #if defined(USE_SX1262) || defined(USE_SX1268)
 void MyMesh::setRxBoostedGain(bool enable) {
   radio_driver.setRxBoostedGainMode(enable);
@@ -1134,17 +1208,48 @@ void MyMesh::onDefaultRegionChanged(const RegionEntry* r) {
 }
 
 void MyMesh::formatStatsReply(char *reply) {
-  StatsFormatHelper::formatCoreStats(reply, board, *_ms, _err_flags, _mgr);
+  StatsFormatHelper::formatCoreStats(reply, board, *_ms, _err_flags, _mgr, *getSharedSecretCache());
 }
 
 void MyMesh::formatRadioStatsReply(char *reply) {
-  StatsFormatHelper::formatRadioStats(reply, _radio, radio_driver, getTotalAirTime(), getReceiveAirTime());
+  StatsFormatHelper::formatRadioStats(reply, _radio, radio_driver, getTotalAirTime(), getReceiveAirTime(),
+                                      getChannelUtilisation(8000), getChannelUtilisation(60000), getNumForcedSends());
+  if (duty_band >= 0) {   // append the rolling window duty-cycle usage, inside the closing brace
+    uint32_t used = duty_ledger.getUsedMillis(duty_band, _ms->getMillis());
+    uint32_t limit = duty_ledger.getLimitMillis(duty_band);
+    sprintf(strchr(reply, 0) - 1, ",\"dc_used_ms\":%u,\"dc_headroom_ms\":%u}", used, used < limit ? limit - used : 0);
+  }
+}
+
+bool MyMesh::getTxDutyCycleDelay(uint32_t airtime, uint32_t& delay_millis) {
+  delay_millis = 0;
+  if (duty_band < 0) return true;   // not in a duty-cycle limited sub-band
+
+  uint32_t now = _ms->getMillis();
+  uint32_t when;
+  if (!duty_ledger.getEarliestTxTime(duty_band, now, airtime, when)) return false;
+  delay_millis = when - now;
+  return true;
 }
 
 void MyMesh::formatPacketStatsReply(char *reply) {
   StatsFormatHelper::formatPacketStats(reply, radio_driver, getNumSentFlood(), getNumSentDirect(), 
-                                       getNumRecvFlood(), getNumRecvDirect());
+                                       getNumRecvFlood(), getNumRecvDirect(), _mgr);
+}
+
+void MyMesh::formatTxStatsReply(char *reply) {
+  StatsFormatHelper::formatTxClassStats(reply, _mgr, getNumFloodSuppressed(), getFloodSuppressedAirTime());
+}
+
+void MyMesh::formatAdvertStatsReply(char *reply) {
+  StatsFormatHelper::formatAdvertVerifyStats(reply, getAdvertVerifyStats());
+}
+
+#if MESH_LATENCY_STATS
+void MyMesh::formatLatencyStatsReply(char *reply, const char* stage) {
+  StatsFormatHelper::formatLatencyStats(reply, getLatencyStats(), stage);
 }
+#endif
 
 void MyMesh::saveIdentity(const mesh::LocalIdentity &new_id) {
 #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
@@ -1162,7 +1267,14 @@ void MyMesh::saveIdentity(const mesh::LocalIdentity &new_id) {
 void MyMesh::clearStats() {
   radio_driver.resetStats();
   resetStats();
-  ((SimpleMeshTables *)getTables())->resetStats();
+  getSharedSecretCache()->resetStats();
+  _mgr->resetPoolStats();
+  _mgr->resetTxClassStats();
+  resetAdvertVerifyStats();
+#if MESH_LATENCY_STATS
+  resetLatencyStats();
+#endif
+  ((HashedMeshTables *)getTables())->resetStats();
 }
 
 void MyMesh::handleCommand(uint32_t sender_timestamp, char *command, char *reply) {
@@ -1221,7 +1333,7 @@ void MyMesh::handleCommand(uint32_t sender_timestamp, char *command, char *reply
       int hex_len = min(sp - hex, PUB_KEY_SIZE*2);
       if (mesh::Utils::fromHex(pubkey, hex_len / 2, hex)) {
         uint8_t perms = atoi(sp);
-        if (acl.applyPermissions(self_id, pubkey, hex_len / 2, perms)) {
+        if (acl.applyPermissions(self_id, pubkey, hex_len / 2, perms, getSharedSecretCache())) {
           dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);   // trigger acl.save()
           strcpy(reply, "OK");
         } else {
@@ -1280,12 +1392,18 @@ void MyMesh::loop() {
   if (set_radio_at && millisHasNowPassed(set_radio_at)) { // apply pending (temporary) radio params
     set_radio_at = 0;                                     // clear timer
     radio_set_params(pending_freq, pending_bw, pending_sf, pending_cr);
+    radio_freq = pending_freq;
+    radio_sf = pending_sf;
+    setDutyCycleBands(_prefs.duty_cycle_bands);
     MESH_DEBUG_PRINTLN("Temp radio params");
   }
 
   if (revert_radio_at && millisHasNowPassed(revert_radio_at)) { // revert radio params to orig
     revert_radio_at = 0;                                        // clear timer
     radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
+    radio_freq = _prefs.freq;
+    radio_sf = _prefs.sf;
+    setDutyCycleBands(_prefs.duty_cycle_bands);
     MESH_DEBUG_PRINTLN("Radio params restored");
   }
 
@@ -1295,16 +1413,107 @@ void MyMesh::loop() {
     dirty_contacts_expiry = 0;
   }
 
+  if (_warm && _warm->isRetained() && millisHasNowPassed(next_warm_sync)) {   // refresh the retained copy
+    snapshotWarmState();
+    next_warm_sync = futureMillis(WARM_STATE_SYNC_SECS * 1000);
+  }
+
   // update uptime
   uint32_t now = millis();
   uptime_millis += now - last_millis;
   last_millis = now;
 }
 
+#define SAVED_NEIGHBOUR_SIZE  (PUB_KEY_SIZE + 4 + 4 + 1)
+
+void MyMesh::snapshotWarmState() {
+  int max_len, len;
+  uint8_t* dest;
+  _warm->beginSave();
+
+#if MESH_FAST_DEDUPE_HASH
+  if ((dest = _warm->beginSection(WARM_SECTION_DEDUPE_KEY, max_len)) != NULL && max_len >= 16) {
+    mesh::Packet::getDedupeHashKey(dest);   // the table entries are only valid with same key
+    _warm->endSection(16);
+  }
+#endif
+  if ((dest = _warm->beginSection(WARM_SECTION_TRANSPORT_KEYS, max_len)) != NULL) {
+    _warm->endSection(key_store.saveCacheTo(dest, max_len));
+  }
+  if ((dest = _warm->beginSection(WARM_SECTION_TABLES, max_len)) != NULL) {
+    len = ((HashedMeshTables *)getTables())->saveTo(dest, max_len * 2 / 3);   // leave some room for neighbours
+    _warm->endSection(len);
+  }
+#if MAX_NEIGHBOURS
+  if ((dest = _warm->beginSection(WARM_SECTION_NEIGHBOURS, max_len)) != NULL) {
+    len = 0;
+    for (int i = 0; i < MAX_NEIGHBOURS && len + SAVED_NEIGHBOUR_SIZE <= max_len; i++) {
+      auto n = &neighbours[i];
+      if (n->heard_timestamp == 0) continue;   // unused
+
+      memcpy(&dest[len], n->id.pub_key, PUB_KEY_SIZE); len += PUB_KEY_SIZE;
+      memcpy(&dest[len], &n->advert_timestamp, 4); len += 4;
+      memcpy(&dest[len], &n->heard_timestamp, 4); len += 4;
+      dest[len++] = n->snr;
+    }
+    _warm->endSection(len);
+  }
+#endif
+
+  _warm->endSave(getRTCClock()->getCurrentTime());
+}
+
+void MyMesh::restoreWarmState() {
+  if (_warm == NULL || !_warm->load(_fs, getRTCClock())) return;
+
+  const uint8_t* src;
+  int len;
+  uint32_t elapsed = _warm->getElapsedSecs();
+  MESH_DEBUG_PRINTLN("Restoring warm state, taken %u secs ago", elapsed);
+
+#if MESH_FAST_DEDUPE_HASH
+  if ((src = _warm->findSection(WARM_SECTION_DEDUPE_KEY, len)) != NULL && len == 16) {
+    mesh::Packet::setDedupeHashKey(src);
+  } else {   // can't make sense of the table entries
+    elapsed = 0xFFFFFFFF;
+  }
+#endif
+  if ((src = _warm->findSection(WARM_SECTION_TRANSPORT_KEYS, len)) != NULL) {
+    key_store.restoreCacheFrom(src, len);
+  }
+  if (elapsed != 0xFFFFFFFF && (src = _warm->findSection(WARM_SECTION_TABLES, len)) != NULL) {
+    ((HashedMeshTables *)getTables())->restoreFrom(src, len, elapsed);
+  }
+#if MAX_NEIGHBOURS
+  if ((src = _warm->findSection(WARM_SECTION_NEIGHBOURS, len)) != NULL) {
+    for (int i = 0; i + SAVED_NEIGHBOUR_SIZE <= len && i / SAVED_NEIGHBOUR_SIZE < MAX_NEIGHBOURS; i += SAVED_NEIGHBOUR_SIZE) {
+      auto n = &neighbours[i / SAVED_NEIGHBOUR_SIZE];
+      memcpy(n->id.pub_key, &src[i], PUB_KEY_SIZE);
+      memcpy(&n->advert_timestamp, &src[i + PUB_KEY_SIZE], 4);
+      memcpy(&n->heard_timestamp, &src[i + PUB_KEY_SIZE + 4], 4);
+      n->snr = (int8_t) src[i + PUB_KEY_SIZE + 8];
+    }
+  }
+#endif
+  _warm->release();
+}
+
+void MyMesh::saveWarmState() {
+  if (_warm == NULL) return;
+
+  snapshotWarmState();
+  _warm->saveFile(_fs);   // for when RAM isn't retained, eg. power off
+  _warm->release();
+}
+
+void MyMesh::clearWarmState() {
+  if (_warm) _warm->invalidate();
+}
+
 // To check if there is pending work
 bool MyMesh::hasPendingWork() const {
 #if defined(WITH_BRIDGE)
   if (bridge.isRunning()) return true;  // bridge needs WiFi radio, can't sleep
 #endif
-  return _mgr->getOutboundTotal() > 0;
+  return false;   // NOTE: queued packets are covered by getMillisToNextEvent()
 }
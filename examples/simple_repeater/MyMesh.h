@@ -27,12 +27,15 @@
 #include <helpers/ArduinoHelpers.h>
 #include <helpers/ClientACL.h>
 #include <helpers/CommonCLI.h>
+#include <helpers/DutyCycleLedger.h>
 #include <helpers/IdentityStore.h>
-#include <helpers/SimpleMeshTables.h>
-#include <helpers/StaticPoolPacketManager.h>
+#include <helpers/HashedMeshTables.h>
+#include <helpers/FairPacketManager.h>
+#include <helpers/SlabPacketManager.h>
 #include <helpers/StatsFormatHelper.h>
 #include <helpers/TxtDataHelpers.h>
 #include <helpers/RegionMap.h>
+#include <helpers/WarmState.h>
 #include "RateLimiter.h"
 
 #ifdef WITH_BRIDGE
@@ -65,9 +68,14 @@ struct NeighbourInfo {
   mesh::Identity id;
   uint32_t advert_timestamp;
   uint32_t heard_timestamp;
+  uint32_t relay_timestamp;   // last heard relaying a flood packet (by OUR clock)
   int8_t snr; // multiplied by 4, user should divide to get float value
 };
 
+#ifndef LIVE_NEIGHBOUR_SECS
+  #define LIVE_NEIGHBOUR_SECS   (15*60)   // neighbours heard (advert, or relaying a flood) within this count towards the adaptive flood delay
+#endif
+
 #ifndef FIRMWARE_BUILD_DATE
   #define FIRMWARE_BUILD_DATE   "19 Apr 2026"
 #endif
@@ -103,11 +111,19 @@ class MyMesh : public mesh::Mesh, public CommonCLICallbacks {
   unsigned long pending_discover_until;
   bool region_load_active;
   unsigned long dirty_contacts_expiry;
+  WarmState* _warm;
+  unsigned long next_warm_sync;
+  FixedFloodDelay fixed_delay;
+  AdaptiveFloodDelay adaptive_delay;
 #if MAX_NEIGHBOURS
   NeighbourInfo neighbours[MAX_NEIGHBOURS];
 #endif
   CayenneLPP telemetry;
   unsigned long set_radio_at, revert_radio_at;
+  DutyCycleLedger duty_ledger;
+  int duty_band;    // sub-band of current radio freq (-1 if not duty-cycle limited, or limits are off)
+  float radio_freq; // current radio freq, incl. temp radio params
+  uint8_t radio_sf; // current spreading factor, incl. temp radio params
   float pending_freq;
   float pending_bw;
   uint8_t pending_sf;
@@ -120,6 +136,8 @@ class MyMesh : public mesh::Mesh, public CommonCLICallbacks {
 #endif
 
   void putNeighbour(const mesh::Identity& id, uint32_t timestamp, float snr);
+  void touchRelayNeighbour(const mesh::Packet* pkt);
+  int countLiveNeighbours();
   uint8_t handleLoginReq(const mesh::Identity& sender, const uint8_t* secret, uint32_t sender_timestamp, const uint8_t* data, bool is_flood);
   uint8_t handleAnonRegionsReq(const mesh::Identity& sender, uint32_t sender_timestamp, const uint8_t* data);
   uint8_t handleAnonOwnerReq(const mesh::Identity& sender, uint32_t sender_timestamp, const uint8_t* data);
@@ -156,6 +174,16 @@ protected:
   uint8_t getExtraAckTransmitCount() const override {
     return _prefs.multi_acks;
   }
+  uint8_t getFloodSuppressThreshold() const override {
+    return _prefs.flood_suppress;
+  }
+  bool isFloodSuppressSNRWeighted() const override {
+    return _prefs.flood_suppress_snr;
+  }
+  bool getTxDutyCycleDelay(uint32_t airtime, uint32_t& delay_millis) override;
+  void onTxAirtime(unsigned long start, uint32_t airtime) override {
+    duty_ledger.recordTx(duty_band, start, airtime);
+  }
 
 #if ENV_INCLUDE_GPS == 1
   void applyGpsPrefs() {
@@ -174,11 +202,13 @@ protected:
   void onControlDataRecv(mesh::Packet* packet) override;
 
   void sendFloodReply(mesh::Packet* packet, unsigned long delay_millis, uint8_t path_hash_size);
+  void snapshotWarmState();
+  void restoreWarmState();
 
 public:
   MyMesh(mesh::MainBoard& board, mesh::Radio& radio, mesh::MillisecondClock& ms, mesh::RNG& rng, mesh::RTCClock& rtc, mesh::MeshTables& tables);
 
-  void begin(FILESYSTEM* fs);
+  void begin(FILESYSTEM* fs, WarmState* warm=NULL);
   void sendNodeDiscoverReq();
   const char* getFirmwareVer() override { return FIRMWARE_VERSION; }
   const char* getBuildDate() override { return FIRMWARE_BUILD_DATE; }
@@ -214,6 +244,11 @@ public:
   void formatStatsReply(char *reply) override;
   void formatRadioStatsReply(char *reply) override;
   void formatPacketStatsReply(char *reply) override;
+  void formatTxStatsReply(char *reply) override;
+  void formatAdvertStatsReply(char *reply) override;
+#if MESH_LATENCY_STATS
+  void formatLatencyStatsReply(char *reply, const char* stage) override;
+#endif
   void startRegionsLoad() override;
   bool saveRegions() override;
   void onDefaultRegionChanged(const RegionEntry* r) override;
@@ -222,6 +257,8 @@ public:
 
   void saveIdentity(const mesh::LocalIdentity& new_id) override;
   void clearStats() override;
+  void saveWarmState() override;
+  void clearWarmState() override;
 
   void handleCommand(uint32_t sender_timestamp, char* command, char* reply);
   void loop();
@@ -249,6 +286,11 @@ public:
   // To check if there is pending work
   bool hasPendingWork() const;
 
+  bool setTxClassWeights(const uint8_t weights[]) override;
+  bool setFloodSuppress(uint8_t threshold, bool snr_weighted) override;
+  bool setFloodDelayMode(uint8_t mode) override;
+  bool setDutyCycleBands(bool enable) override;
+
 #if defined(USE_SX1262) || defined(USE_SX1268)
   void setRxBoostedGain(bool enable) override;
 #endif
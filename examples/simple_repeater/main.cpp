@@ -9,9 +9,17 @@
 #endif
 
 StdRNG fast_rng;
-SimpleMeshTables tables;
+ArduinoMillis ms_clock;
+HashedMeshTables tables(ms_clock);
 
-MyMesh the_mesh(board, radio_driver, *new ArduinoMillis(), fast_rng, rtc_clock, tables);
+#if WARM_STATE_RETAINED
+WARM_STATE_ATTR static uint8_t warm_buf[WARM_STATE_SIZE];
+WarmState warm_state(warm_buf, sizeof(warm_buf));
+#else
+WarmState warm_state(WARM_STATE_SIZE);   // only the flash record, so buffer is allocated just when needed
+#endif
+
+MyMesh the_mesh(board, radio_driver, ms_clock, fast_rng, rtc_clock, tables);
 
 void halt() {
   while (1) ;
@@ -93,7 +101,7 @@ void setup() {
 
   sensors.begin();
 
-  the_mesh.begin(fs);
+  the_mesh.begin(fs, &warm_state);
 
 #ifdef DISPLAY_CLASS
   ui_task.begin(the_mesh.getNodePrefs(), FIRMWARE_BUILD_DATE, FIRMWARE_VERSION);
@@ -123,7 +131,7 @@ void loop() {
   if (len > 0 && command[len - 1] == '\r') {  // received complete line
     Serial.print('\n');
     command[len - 1] = 0;  // replace newline with C string null terminator
-    char reply[160];
+    char reply[224];
     the_mesh.handleCommand(0, command, reply);  // NOTE: there is no sender_timestamp via serial!
     if (reply[0]) {
       Serial.print("  -> "); Serial.println(reply);
@@ -140,6 +148,7 @@ void loop() {
       userBtnDownAt = millis();
     } else if ((unsigned long)(millis() - userBtnDownAt) >= USER_BTN_HOLD_OFF_MILLIS) {
       Serial.println("Powering off...");
+      the_mesh.saveWarmState();
       board.powerOff();  // does not return
     }
   } else {
@@ -155,13 +164,19 @@ void loop() {
   rtc_clock.tick();
 
   if (the_mesh.getNodePrefs()->powersaving_enabled && !the_mesh.hasPendingWork()) {
+    // don't sleep past the next Dispatcher deadline (eg. delayed rx/tx queues, TX backoff), max 30 minutes
+    uint32_t sleep_millis = the_mesh.getMillisToNextEvent(1800*1000UL);
     #if defined(NRF52_PLATFORM)
-    board.sleep(1800); // nrf ignores seconds param, sleeps whenever possible
+    if (sleep_millis > 0) {
+      board.sleep(sleep_millis / 1000); // nrf ignores seconds param, sleeps until next interrupt
+    }
     #else
     if (the_mesh.millisHasNowPassed(lastActive + nextSleepinSecs * 1000)) { // To check if it is time to sleep
-      board.sleep(1800);             // To sleep. Wake up after 30 minutes or when receiving a LoRa packet
-      lastActive = millis();
-      nextSleepinSecs = 5;  // Default: To work for 5s and sleep again
+      if (sleep_millis >= 1000) {   // whole seconds only, rounded down so deadline is never missed
+        board.sleep(sleep_millis / 1000);  // To sleep. Wake up at next deadline or when receiving a LoRa packet
+        lastActive = millis();
+        nextSleepinSecs = 5;  // Default: To work for 5s and sleep again
+      }
     } else {
       nextSleepinSecs += 5; // When there is pending work, to work another 5s
     }
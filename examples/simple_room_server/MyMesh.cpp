@@ -153,8 +153,8 @@ int MyMesh::handleRequest(ClientInfo *sender, uint32_t sender_timestamp, uint8_t
     stats.n_recv_direct = getNumRecvDirect();
     stats.err_events = _err_flags;
     stats.last_snr = (int16_t)(radio_driver.getLastSNR() * 4);
-    stats.n_direct_dups = ((SimpleMeshTables *)getTables())->getNumDirectDups();
-    stats.n_flood_dups = ((SimpleMeshTables *)getTables())->getNumFloodDups();
+    stats.n_direct_dups = ((HashedMeshTables *)getTables())->getNumDirectDups();
+    stats.n_flood_dups = ((HashedMeshTables *)getTables())->getNumFloodDups();
     stats.n_posted = _num_posted;
     stats.n_post_push = _num_post_pushes;
 
@@ -259,7 +259,7 @@ void MyMesh::logTxFail(mesh::Packet *pkt, int len) {
 
 int MyMesh::calcRxDelay(float score, uint32_t air_time) const {
   if (_prefs.rx_delay_base <= 0.0f) return 0;
-  return (int)((pow(_prefs.rx_delay_base, 0.85f - score) - 1.0) * air_time);
+  return calcScoreDelay(_prefs.rx_delay_base, score, air_time);
 }
 
 const char *MyMesh::getLogDateTime() {
@@ -611,7 +611,7 @@ void MyMesh::onAckRecv(mesh::Packet *packet, uint32_t ack_crc) {
 
 MyMesh::MyMesh(mesh::MainBoard &board, mesh::Radio &radio, mesh::MillisecondClock &ms, mesh::RNG &rng,
                mesh::RTCClock &rtc, mesh::MeshTables &tables)
-    : mesh::Mesh(radio, ms, rng, rtc, *new StaticPoolPacketManager(32), tables),
+    : mesh::Mesh(radio, ms, rng, rtc, *new HeapPacketManager(32), tables),
       region_map(key_store), temp_map(key_store),
       _cli(board, rtc, sensors, region_map, acl, &_prefs, this),
       telemetry(MAX_PACKET_PAYLOAD - 4)
@@ -620,6 +620,8 @@ MyMesh::MyMesh(mesh::MainBoard &board, mesh::Radio &radio, mesh::MillisecondCloc
   uptime_millis = 0;
   next_local_advert = next_flood_advert = 0;
   dirty_contacts_expiry = 0;
+  _warm = NULL;
+  next_warm_sync = 0;
   _logging = false;
   region_load_active = false;
   set_radio_at = revert_radio_at = 0;
@@ -662,14 +664,16 @@ MyMesh::MyMesh(mesh::MainBoard &board, mesh::Radio &radio, mesh::MillisecondCloc
   memset(default_scope.key, 0, sizeof(default_scope.key));
 }
 
-void MyMesh::begin(FILESYSTEM *fs) {
+void MyMesh::begin(FILESYSTEM *fs, WarmState* warm) {
   mesh::Mesh::begin();
   _fs = fs;
+  _warm = warm;
   // load persisted prefs
   _cli.loadPrefs(_fs);
 
-  acl.load(_fs, self_id);
+  acl.load(_fs, self_id, getSharedSecretCache());
   region_map.load(_fs);
+  restoreWarmState();
 
   // establish default-scope
   {
@@ -834,15 +838,17 @@ void MyMesh::onDefaultRegionChanged(const RegionEntry* r) {
 void MyMesh::clearStats() {
   radio_driver.resetStats();
   resetStats();
-  ((SimpleMeshTables *)getTables())->resetStats();
+  getSharedSecretCache()->resetStats();
+  ((HashedMeshTables *)getTables())->resetStats();
 }
 
 void MyMesh::formatStatsReply(char *reply) {
-  StatsFormatHelper::formatCoreStats(reply, board, *_ms, _err_flags, _mgr);
+  StatsFormatHelper::formatCoreStats(reply, board, *_ms, _err_flags, _mgr, *getSharedSecretCache());
 }
 
 void MyMesh::formatRadioStatsReply(char *reply) {
-  StatsFormatHelper::formatRadioStats(reply, _radio, radio_driver, getTotalAirTime(), getReceiveAirTime());
+  StatsFormatHelper::formatRadioStats(reply, _radio, radio_driver, getTotalAirTime(), getReceiveAirTime(),
+                                      getChannelUtilisation(8000), getChannelUtilisation(60000), getNumForcedSends());
 }
 
 void MyMesh::formatPacketStatsReply(char *reply) {
@@ -907,7 +913,7 @@ void MyMesh::handleCommand(uint32_t sender_timestamp, char *command, char *reply
       int hex_len = min(sp - hex, PUB_KEY_SIZE*2);
       if (mesh::Utils::fromHex(pubkey, hex_len / 2, hex)) {
         uint8_t perms = atoi(sp);
-        if (acl.applyPermissions(self_id, pubkey, hex_len / 2, perms)) {
+        if (acl.applyPermissions(self_id, pubkey, hex_len / 2, perms, getSharedSecretCache())) {
           dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);   // trigger acl.save()
           strcpy(reply, "OK");
         } else {
@@ -1017,8 +1023,70 @@ void MyMesh::loop() {
 
   // TODO: periodically check for OLD/inactive entries in known_clients[], and evict
 
+  if (_warm && _warm->isRetained() && millisHasNowPassed(next_warm_sync)) {   // refresh the retained copy
+    snapshotWarmState();
+    next_warm_sync = futureMillis(WARM_STATE_SYNC_SECS * 1000);
+  }
+
   // update uptime
   uint32_t now = millis();
   uptime_millis += now - last_millis;
   last_millis = now;
 }
+
+void MyMesh::snapshotWarmState() {
+  int max_len;
+  uint8_t* dest;
+  _warm->beginSave();
+
+#if MESH_FAST_DEDUPE_HASH
+  if ((dest = _warm->beginSection(WARM_SECTION_DEDUPE_KEY, max_len)) != NULL && max_len >= 16) {
+    mesh::Packet::getDedupeHashKey(dest);   // the table entries are only valid with same key
+    _warm->endSection(16);
+  }
+#endif
+  if ((dest = _warm->beginSection(WARM_SECTION_TRANSPORT_KEYS, max_len)) != NULL) {
+    _warm->endSection(key_store.saveCacheTo(dest, max_len));
+  }
+  if ((dest = _warm->beginSection(WARM_SECTION_TABLES, max_len)) != NULL) {
+    _warm->endSection(((HashedMeshTables *)getTables())->saveTo(dest, max_len));
+  }
+
+  _warm->endSave(getRTCClock()->getCurrentTime());
+}
+
+void MyMesh::restoreWarmState() {
+  if (_warm == NULL || !_warm->load(_fs, getRTCClock())) return;
+
+  const uint8_t* src;
+  int len;
+  uint32_t elapsed = _warm->getElapsedSecs();
+  MESH_DEBUG_PRINTLN("Restoring warm state, taken %u secs ago", elapsed);
+
+#if MESH_FAST_DEDUPE_HASH
+  if ((src = _warm->findSection(WARM_SECTION_DEDUPE_KEY, len)) != NULL && len == 16) {
+    mesh::Packet::setDedupeHashKey(src);
+  } else {   // can't make sense of the table entries
+    elapsed = 0xFFFFFFFF;
+  }
+#endif
+  if ((src = _warm->findSection(WARM_SECTION_TRANSPORT_KEYS, len)) != NULL) {
+    key_store.restoreCacheFrom(src, len);
+  }
+  if (elapsed != 0xFFFFFFFF && (src = _warm->findSection(WARM_SECTION_TABLES, len)) != NULL) {
+    ((HashedMeshTables *)getTables())->restoreFrom(src, len, elapsed);
+  }
+  _warm->release();
+}
+
+void MyMesh::saveWarmState() {
+  if (_warm == NULL) return;
+
+  snapshotWarmState();
+  _warm->saveFile(_fs);   // for when RAM isn't retained, eg. power off
+  _warm->release();
+}
+
+void MyMesh::clearWarmState() {
+  if (_warm) _warm->invalidate();
+}
@@ -9,8 +9,17 @@
 #endif
 
 StdRNG fast_rng;
-SimpleMeshTables tables;
-MyMesh the_mesh(board, radio_driver, *new ArduinoMillis(), fast_rng, rtc_clock, tables);
+ArduinoMillis ms_clock;
+HashedMeshTables tables(ms_clock);
+
+#if WARM_STATE_RETAINED
+WARM_STATE_ATTR static uint8_t warm_buf[WARM_STATE_SIZE];
+WarmState warm_state(warm_buf, sizeof(warm_buf));
+#else
+WarmState warm_state(WARM_STATE_SIZE);   // only the flash record, so buffer is allocated just when needed
+#endif
+
+MyMesh the_mesh(board, radio_driver, ms_clock, fast_rng, rtc_clock, tables);
 
 void halt() {
   while (1) ;
@@ -70,7 +79,7 @@ void setup() {
 
   sensors.begin();
 
-  the_mesh.begin(fs);
+  the_mesh.begin(fs, &warm_state);
 
 #ifdef DISPLAY_CLASS
   ui_task.begin(the_mesh.getNodePrefs(), FIRMWARE_BUILD_DATE, FIRMWARE_VERSION);
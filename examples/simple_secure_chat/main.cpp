@@ -10,7 +10,7 @@
 #endif
 
 #include <helpers/ArduinoHelpers.h>
-#include <helpers/StaticPoolPacketManager.h>
+#include <helpers/HeapPacketManager.h>
 #include <helpers/SimpleMeshTables.h>
 #include <helpers/IdentityStore.h>
 #include <RTClib.h>
@@ -117,7 +117,7 @@ class MyMesh : public BaseChatMesh, ContactVisitor {
           if (!success) break;  // EOF
 
           c.id = mesh::Identity(pub_key);
-          c.lastmod = 0;
+          c.lastmod = c.last_advert_timestamp;   // not saved, so best guess for recent list order
           if (!addContact(c)) full = true;
         }
         file.close();
@@ -277,7 +277,7 @@ protected:
 
 public:
   MyMesh(mesh::Radio& radio, StdRNG& rng, mesh::RTCClock& rtc, SimpleMeshTables& tables)
-     : BaseChatMesh(radio, *new ArduinoMillis(), rng, rtc, *new StaticPoolPacketManager(16), tables)
+     : BaseChatMesh(radio, *new ArduinoMillis(), rng, rtc, *new HeapPacketManager(16), tables)
   {
     // defaults
     memset(&_prefs, 0, sizeof(_prefs));
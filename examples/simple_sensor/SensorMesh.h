@@ -14,7 +14,7 @@
 #endif
 
 #include <helpers/ArduinoHelpers.h>
-#include <helpers/StaticPoolPacketManager.h>
+#include <helpers/HeapPacketManager.h>
 #include <helpers/SimpleMeshTables.h>
 #include <helpers/IdentityStore.h>
 #include <helpers/AdvertDataHelpers.h>
@@ -16,15 +16,24 @@ namespace mesh {
   #define NOISE_FLOOR_CALIB_INTERVAL   2000     // 2 seconds
 #endif
 
+#ifndef CAD_BACKOFF_SLOT_MILLIS
+  #define CAD_BACKOFF_SLOT_MILLIS    120
+#endif
+#define CAD_BACKOFF_MIN_WINDOW         4     // in slots, ie. first retry is 120-480 ms (on an idle channel)
+#define CAD_BACKOFF_MAX_WINDOW         8     // in slots, ie. max retry delay of 960 ms
+#define CAD_BACKOFF_UTIL_WINDOW     8000     // millis, of channel utilisation to base backoff on
+#define MIN_PERSISTENCE_PERMILLE     250
+
 void Dispatcher::begin() {
   n_sent_flood = n_sent_direct = 0;
   n_recv_flood = n_recv_direct = 0;
   _err_flags = 0;
   radio_nonrx_start = _ms->getMillis();
+  channel_util.reset(_ms->getMillis());
+  n_forced_sends = 0;
 
   duty_cycle_window_ms = getDutyCycleWindowMs();
-  float duty_cycle = 1.0f / (1.0f + getAirtimeBudgetFactor());
-  tx_budget_ms = (unsigned long)(duty_cycle_window_ms * duty_cycle);
+  tx_budget_ms = ((uint64_t)duty_cycle_window_ms * getDutyCycle()) >> 24;
   last_budget_update = _ms->getMillis();
 
   _radio->begin();
@@ -35,13 +44,27 @@ float Dispatcher::getAirtimeBudgetFactor() const {
   return 1.0;
 }
 
+uint32_t Dispatcher::getDutyCycle() {
+  float f = getAirtimeBudgetFactor();
+  if (f != budget_factor) {   // only re-calc when changed, as float division is slow on MCUs without an FPU
+    budget_factor = f;
+    duty_cycle = (uint32_t)(16777216.0f / (1.0f + f) + 0.5f);
+    if (duty_cycle == 0) duty_cycle = 1;
+  }
+  return duty_cycle;
+}
+
+unsigned long Dispatcher::calcBudgetWait(unsigned long needed) {
+  return ((uint64_t)needed << 24) / getDutyCycle();   // ie. needed / duty_cycle
+}
+
 void Dispatcher::updateTxBudget() {
   unsigned long now = _ms->getMillis();
   unsigned long elapsed = now - last_budget_update;
 
-  float duty_cycle = 1.0f / (1.0f + getAirtimeBudgetFactor());
-  unsigned long max_budget = (unsigned long)(getDutyCycleWindowMs() * duty_cycle);
-  unsigned long refill = (unsigned long)(elapsed * duty_cycle);
+  uint32_t dc = getDutyCycle();
+  unsigned long max_budget = ((uint64_t)getDutyCycleWindowMs() * dc) >> 24;
+  unsigned long refill = ((uint64_t)elapsed * dc) >> 24;
   
   if (refill > 0) {
     tx_budget_ms += refill;
@@ -53,11 +76,27 @@ void Dispatcher::updateTxBudget() {
 }
 
 int Dispatcher::calcRxDelay(float score, uint32_t air_time) const {
-  return (int) ((pow(10, 0.85f - score) - 1.0) * air_time);
+  return calcScoreDelay(10.0f, score, air_time);
+}
+
+int Dispatcher::calcScoreDelay(float base, float score, uint32_t air_time) {
+  if (base <= 0.0f) return 0;   // ie. disabled
+
+  // NOTE: pow() costs thousands of cycles in soft-float, so: base^e = 2^(e * log2(base)), with table driven exp2/log2
+  int32_t e = 55706 - (int32_t)(score * 65536.0f);     // 0.85 - score, in 16.16
+  int32_t log_base = Utils::log2Q16((uint32_t)(base * 65536.0f));
+  int64_t p = (int64_t)Utils::exp2Q16((int32_t)(((int64_t)e * log_base) >> 16)) - 65536;
+  return (int)((p * (int64_t)air_time) / 65536);
 }
 
 uint32_t Dispatcher::getCADFailRetryDelay() const {
-  return 200;
+  // binary exponential backoff, over a contention window that also widens with the channel utilisation
+  int n = cad_busy_count > 0 ? cad_busy_count - 1 : 0;
+  uint32_t window = CAD_BACKOFF_MIN_WINDOW << (n < 3 ? n : 3);
+  window = window * (1000 + 2*cad_backoff_util) / 1000;
+  if (window > CAD_BACKOFF_MAX_WINDOW) window = CAD_BACKOFF_MAX_WINDOW;
+
+  return CAD_BACKOFF_SLOT_MILLIS * (1 + nextRandomInt(window));
 }
 uint32_t Dispatcher::getCADFailMaxDuration() const {
   return 4000;   // 4 seconds
@@ -86,6 +125,8 @@ void Dispatcher::loop() {
     if (_radio->isSendComplete()) {
       long t = _ms->getMillis() - outbound_start;
       total_air_time += t;
+      onTxAirtime(outbound_start, t);
+      MESH_LATENCY_RECORD(LAT_STAGE_TX_AIRTIME, LatencyHistograms::getKey(outbound), t);
       //Serial.print("  airtime="); Serial.println(t);
 
       updateTxBudget();
@@ -97,9 +138,8 @@ void Dispatcher::loop() {
       }
 
       if (tx_budget_ms < MIN_TX_BUDGET_RESERVE_MS) {
-        float duty_cycle = 1.0f / (1.0f + getAirtimeBudgetFactor());
         unsigned long needed = MIN_TX_BUDGET_RESERVE_MS - tx_budget_ms;
-        next_tx_time = futureMillis((unsigned long)(needed / duty_cycle));
+        next_tx_time = futureMillis(calcBudgetWait(needed));
       } else {
         next_tx_time = _ms->getMillis();
       }
@@ -138,6 +178,7 @@ void Dispatcher::loop() {
   {
     Packet* pkt = _mgr->getNextInbound(_ms->getMillis());
     if (pkt) {
+      MESH_LATENCY_RECORD(LAT_STAGE_RX_DELAY, LatencyHistograms::getKey(pkt), _ms->getMillis() - pkt->_lat_stamp);
       processRecvPacket(pkt);
     }
   }
@@ -145,8 +186,52 @@ void Dispatcher::loop() {
   checkSend();
 }
 
+// keeps 'best' as the earliest of the deadlines, in millis relative to 'now'
+static void earliestDeadline(int32_t& best, uint32_t deadline, uint32_t now) {
+  int32_t remaining = (int32_t)(deadline - now);
+  if (remaining < best) best = remaining;
+}
+
+uint32_t Dispatcher::getMillisToNextEvent(uint32_t max_millis) const {
+  if (_radio->needsPolling()) return 0;
+
+  uint32_t now = _ms->getMillis();
+  int32_t best = max_millis;
+  // NOTE: millisHasNowPassed(t) becomes true at t + 1
+
+  if (getInterferenceThreshold() > 0) {   // otherwise noise floor is just telemetry, fine to re-calibrate late
+    earliestDeadline(best, next_floor_calib_time + 1, now);
+  }
+  if (!prev_isrecv_mode) {
+    earliestDeadline(best, radio_nonrx_start + 8001, now);   // the 'stuck' radio check
+  }
+
+  if (outbound) {
+    earliestDeadline(best, outbound_expiry + 1, now);   // send completion is signalled by radio interrupt
+  } else {
+    if (getAGCResetInterval() > 0) {
+      earliestDeadline(best, next_agc_reset_time + 1, now);
+    }
+
+    uint32_t t;
+    if (_mgr->getNextInboundTime(now, t)) {
+      earliestDeadline(best, t, now);
+    }
+    if (held_outbound) {
+      earliestDeadline(best, next_tx_time + 1, now);
+    } else if (_mgr->getNextOutboundTime(now, t)) {
+      if ((int32_t)(next_tx_time + 1 - t) > 0) {
+        t = next_tx_time + 1;   // can't send until after next_tx_time (duty-cycle or CAD backoff)
+      }
+      earliestDeadline(best, t, now);
+    }
+  }
+  return best > 0 ? best : 0;
+}
+
 bool Dispatcher::tryParsePacket(Packet* pkt, const uint8_t* raw, int len) {
   int i = 0;
+  pkt->invalidateHash();
 
   pkt->header = raw[i++];
   if (pkt->getPayloadVer() > PAYLOAD_VER_1) {
@@ -187,25 +272,98 @@ bool Dispatcher::tryParsePacket(Packet* pkt, const uint8_t* raw, int len) {
   return true;  // success
 }
 
+Dispatcher::RecvFrame* Dispatcher::findRecvFrame(const Packet* pkt) {
+#if RECV_FRAME_POOL_SIZE > 0
+  for (int i = 0; i < RECV_FRAME_POOL_SIZE; i++) {
+    if (recv_frames[i].owner == pkt) return &recv_frames[i];
+  }
+#endif
+  return NULL;
+}
+
+void Dispatcher::releaseRecvFrame(const Packet* pkt) {
+  RecvFrame* frame = findRecvFrame(pkt);
+  if (frame) frame->owner = NULL;
+}
+
+bool Dispatcher::forwardRecvFrame(const Packet* pkt) {
+  RecvFrame* frame = findRecvFrame(pkt);
+  if (frame == NULL || frame->is_forward) return false;
+
+  // the path has lost one hash since it was received, everything else is unchanged
+  int removed = frame->len - pkt->getRawLength();
+  if (removed != pkt->getPathHashSize()) return false;
+
+  // shift header (and transport codes) along, over the removed hash, then put in the new path_len
+  int prefix_len = pkt->hasTransportCodes() ? 5 : 1;
+  uint8_t* src = &frame->buf[frame->start];
+  memmove(&src[removed], src, prefix_len);
+  frame->start += removed;
+  frame->len -= removed;
+  frame->buf[frame->start + prefix_len] = pkt->path_len;
+  frame->is_forward = true;
+  return true;
+}
+
+const uint8_t* Dispatcher::getForwardFrame(const Packet* pkt) {
+  RecvFrame* frame = findRecvFrame(pkt);
+  if (frame == NULL || !frame->is_forward) return NULL;
+
+  // NOTE: 'owner' is just the Packet address. A PacketManager can free and reuse it (eg. SlabPacketManager decodes
+  //   each dequeued record into a recycled Packet), so only send the frame if it still holds exactly this Packet
+  const uint8_t* src = &frame->buf[frame->start];
+  int prefix_len = pkt->hasTransportCodes() ? 5 : 1;
+  int path_byte_len = pkt->getPathByteLen();
+  if (frame->len != pkt->getRawLength() || src[0] != pkt->header
+      || (prefix_len > 1 && memcmp(&src[1], pkt->transport_codes, 4) != 0)
+      || src[prefix_len] != pkt->path_len
+      || memcmp(&src[prefix_len + 1], pkt->path, path_byte_len) != 0
+      || memcmp(&src[prefix_len + 1 + path_byte_len], pkt->payload, pkt->payload_len) != 0) {
+    frame->owner = NULL;   // Packet was modified or reused since, so just serialise it
+    return NULL;
+  }
+  return src;
+}
+
+const uint8_t* Dispatcher::getRecvFrame(const Packet* pkt, int& len) {
+  RecvFrame* frame = pkt ? findRecvFrame(pkt) : NULL;
+  if (frame == NULL) return NULL;
+
+  len = frame->len;
+  return &frame->buf[frame->start];
+}
+
 void Dispatcher::checkRecv() {
   Packet* pkt;
   float score;
   uint32_t air_time;
   {
-    uint8_t raw[MAX_TRANS_UNIT+1];
+    uint8_t tmp[MAX_TRANS_UNIT+1];
+    RecvFrame* frame = findRecvFrame(NULL);   // a free one, so radio can receive straight into it
+    uint8_t* raw = frame ? frame->buf : tmp;
     int len = _radio->recvRaw(raw, MAX_TRANS_UNIT);
     if (len > 0) {
       logRxRaw(_radio->getLastSNR(), _radio->getLastRSSI(), raw, len);
+      channel_util.addBusy(_ms->getMillis(), _radio->getEstAirtimeFor(len));   // overheard, even if not valid
 
       pkt = _mgr->allocNew();
       if (pkt == NULL) {
         MESH_DEBUG_PRINTLN("%s Dispatcher::checkRecv(): WARNING: received data, no unused packets available!", getLogDateTime());
       } else {
+        MESH_LATENCY_START(t_parse);
         if (tryParsePacket(pkt, raw, len)) {
+          MESH_LATENCY_RECORD(LAT_STAGE_RX_PARSE, LatencyHistograms::getKey(pkt), _ms->getMicros() - t_parse);
           pkt->_snr = _radio->getLastSNR() * 4.0f;
           score = _radio->packetScore(_radio->getLastSNR(), len);
           air_time = _radio->getEstAirtimeFor(len);
           rx_air_time += air_time;
+          if (frame) {
+            releaseRecvFrame(pkt);   // in case pkt was freed without releasePacket()
+            frame->owner = pkt;
+            frame->start = 0;
+            frame->len = len;
+            frame->is_forward = false;
+          }
         } else {
           _mgr->free(pkt);  // put back into pool
           pkt = NULL;
@@ -248,6 +406,10 @@ void Dispatcher::checkRecv() {
         if (_delay > MAX_RX_DELAY_MILLIS) {
           _delay = MAX_RX_DELAY_MILLIS;
         }
+        releaseRecvFrame(pkt);   // frames only kept while processed straight away, so the pool never runs dry
+      #if MESH_LATENCY_STATS
+        pkt->_lat_stamp = _ms->getMillis();
+      #endif
         _mgr->queueInbound(pkt, futureMillis(_delay)); // add to delayed inbound queue
       }
     } else {
@@ -257,75 +419,221 @@ void Dispatcher::checkRecv() {
   }
 }
 
+static uint8_t calcDupWeight(const Packet* dup, bool snr_weighted) {
+  if (!snr_weighted) return FLOOD_DUP_WEIGHT_ONE;
+
+  // full weight at >= +5 dB, down to 1/4 at <= -10 dB
+  int snr_x4 = dup->_snr;
+  if (snr_x4 >= 5*4) return FLOOD_DUP_WEIGHT_ONE;
+  if (snr_x4 <= -10*4) return 1;
+  return 1 + (FLOOD_DUP_WEIGHT_ONE - 1) * (snr_x4 + 10*4) / (15*4);
+}
+
+// true if 'a' and 'b' have the same calculateDedupeHash() inputs, ie. are the same flood packet
+static bool isSameFloodPacket(const Packet* a, const Packet* b) {
+  if (a->getPayloadType() != b->getPayloadType() || a->payload_len != b->payload_len) return false;
+  if (a->getPayloadType() == PAYLOAD_TYPE_TRACE && a->path_len != b->path_len) return false;
+  return memcmp(a->payload, b->payload, a->payload_len) == 0;
+}
+
+Dispatcher::FloodDupCount* Dispatcher::findFloodDupCount(const uint8_t* hash) {
+  for (int j = 0; j < FLOOD_SUPPRESS_TRACKED; j++) {
+    if (memcmp(dup_counts[j].hash, hash, MAX_HASH_SIZE) == 0) return &dup_counts[j];
+  }
+  return NULL;
+}
+
+void Dispatcher::trackFloodRebroadcast(const Packet* pkt) {
+  if (getFloodSuppressThreshold() == 0) return;   // disabled
+
+  uint8_t hash[MAX_HASH_SIZE];
+  pkt->calculateDedupeHash(hash);   // NOTE: already calculated by hasSeen(), path isn't part of it
+  FloodDupCount* dc = findFloodDupCount(hash);
+  if (dc == NULL) {   // replace oldest tracked
+    dc = &dup_counts[next_dup_count];
+    next_dup_count = (next_dup_count + 1) % FLOOD_SUPPRESS_TRACKED;
+    memcpy(dc->hash, hash, MAX_HASH_SIZE);
+  }
+  dc->weight = 0;
+}
+
+void Dispatcher::checkFloodSuppress(const Packet* dup) {
+  uint8_t k = getFloodSuppressThreshold();
+  if (k == 0) return;   // disabled
+
+  uint8_t hash[MAX_HASH_SIZE];
+  dup->calculateDedupeHash(hash);
+  FloodDupCount* dc = findFloodDupCount(hash);
+  if (dc == NULL) return;   // not one of our queued rebroadcasts (or no longer tracked)
+
+  dc->weight += calcDupWeight(dup, isFloodSuppressSNRWeighted());
+  if (dc->weight < k * FLOOD_DUP_WEIGHT_ONE) return;
+
+  memset(dc, 0, sizeof(*dc));   // enough neighbours have already rebroadcast it
+
+  // NOTE: only searched once the threshold is met, as the PacketManager may have to decode each queued Packet
+  int n = _mgr->getOutboundTotal();
+  for (int i = 0; i < n; i++) {
+    Packet* queued = _mgr->getOutboundByIdx(i);
+    // only rebroadcasts of received packets (path not empty), not this node's own floods
+    if (queued == NULL || !queued->isRouteFlood() || queued->getPathHashCount() == 0) continue;
+    if (!isSameFloodPacket(queued, dup)) continue;
+
+    queued = _mgr->removeOutboundByIdx(i);
+    if (queued) {
+      MESH_DEBUG_PRINTLN("%s Dispatcher::checkFloodSuppress(): cancelled rebroadcast, type=%d", getLogDateTime(), (uint32_t)queued->getPayloadType());
+      n_flood_suppressed++;
+      flood_suppressed_air_time += _radio->getEstAirtimeFor(queued->getRawLength());
+      _mgr->free(queued);
+    }
+    return;
+  }
+}
+
 void Dispatcher::processRecvPacket(Packet* pkt) {
+  if (pkt->isRouteFlood()) {
+    checkFloodSuppress(pkt);   // NOTE: before onRecvPacket(), which may modify pkt
+  }
+#if MESH_LATENCY_STATS
+  uint8_t key = LatencyHistograms::getKey(pkt);   // NOTE: pkt may be modified by onRecvPacket()
+  _latency.crypto_micros = 0;
+  unsigned long t_process = _ms->getMicros();
+#endif
   DispatcherAction action = onRecvPacket(pkt);
+#if MESH_LATENCY_STATS
+  _latency.record(LAT_STAGE_RX_PROCESS, key, _ms->getMicros() - t_process);
+  if (_latency.crypto_micros > 0) {
+    _latency.record(LAT_STAGE_RX_CRYPTO, key, _latency.crypto_micros);
+  }
+#endif
+  RecvFrame* frame = findRecvFrame(pkt);
+  if (frame && !(frame->is_forward && action != ACTION_RELEASE && action != ACTION_MANUAL_HOLD)) {
+    frame->owner = NULL;   // only cut-through forwards keep their frame
+  }
+  applyRecvAction(pkt, action);
+}
+
+void Dispatcher::applyRecvAction(Packet* pkt, DispatcherAction action) {
   if (action == ACTION_RELEASE) {
-    _mgr->free(pkt);
+    releasePacket(pkt);
   } else if (action == ACTION_MANUAL_HOLD) {
     // sub-class is wanting to manually hold Packet instance, and call releasePacket() at appropriate time
   } else {   // ACTION_RETRANSMIT*
     uint8_t priority = (action >> 24) - 1;
     uint32_t _delay = action & 0xFFFFFF;
 
+  #if MESH_LATENCY_STATS
+    _latency.record(LAT_STAGE_TX_DELAY, LatencyHistograms::getKey(pkt), _delay);
+    pkt->_lat_stamp = futureMillis(_delay);
+  #endif
+    if (pkt->isRouteFlood() && pkt->getPathHashCount() > 0) {
+      trackFloodRebroadcast(pkt);   // so checkFloodSuppress() can count the duplicates heard while it is queued
+    }
     _mgr->queueOutbound(pkt, priority, futureMillis(_delay));
   }
 }
 
 void Dispatcher::checkSend() {
-  if (_mgr->getOutboundCount(_ms->getMillis()) == 0) return;
+  if (held_outbound == NULL && _mgr->getOutboundCount(_ms->getMillis()) == 0) return;
   
   updateTxBudget();
   
   uint32_t est_airtime = _radio->getEstAirtimeFor(MAX_TRANS_UNIT);
   if (tx_budget_ms < est_airtime / MIN_TX_BUDGET_AIRTIME_DIV) {
-    float duty_cycle = 1.0f / (1.0f + getAirtimeBudgetFactor());
     unsigned long needed = est_airtime / MIN_TX_BUDGET_AIRTIME_DIV - tx_budget_ms;
-    next_tx_time = futureMillis((unsigned long)(needed / duty_cycle));
+    next_tx_time = futureMillis(calcBudgetWait(needed));
     return;
   }
   
   if (!millisHasNowPassed(next_tx_time)) return;
-  if (_radio->isReceiving()) {
+  bool is_busy = _radio->isReceiving();
+  if (cad_busy_start == 0) {
+    channel_util.addSample(_ms->getMillis(), is_busy);   // NOTE: not the retries, they're biased towards busy
+  }
+  if (is_busy) {
     if (cad_busy_start == 0) {
       cad_busy_start = _ms->getMillis();   // record when CAD busy state started
+      cad_busy_count = 0;
     }
+    if (cad_busy_count < 255) cad_busy_count++;
 
+    // NOTE: only the backoff window widens with channel utilisation, the max busy duration stays fixed
     if (_ms->getMillis() - cad_busy_start > getCADFailMaxDuration()) {
       _err_flags |= ERR_EVENT_CAD_TIMEOUT;
+      n_forced_sends++;
 
       MESH_DEBUG_PRINTLN("%s Dispatcher::checkSend(): CAD busy max duration reached!", getLogDateTime());
       // channel activity has gone on too long... (Radio might be in a bad state)
       // force the pending transmit below...
     } else {
+      cad_backoff_util = getChannelUtilisation(CAD_BACKOFF_UTIL_WINDOW);
       next_tx_time = futureMillis(getCADFailRetryDelay());
       return;
     }
+  } else if (cad_busy_start != 0) {
+    // channel has just become free, but others may have been waiting on it too... p-persistent: only send now
+    // with a probability that drops as channel utilisation rises, otherwise defer by a slot.
+    uint32_t p = 1000 - getChannelUtilisation(CAD_BACKOFF_UTIL_WINDOW);
+    if (p < MIN_PERSISTENCE_PERMILLE) p = MIN_PERSISTENCE_PERMILLE;
+    if (nextRandomInt(1000) >= p) {
+      cad_busy_start = _ms->getMillis();   // channel was free, so restart the max busy duration
+      next_tx_time = futureMillis(CAD_BACKOFF_SLOT_MILLIS);
+      return;
+    }
   }
+#if MESH_LATENCY_STATS
+  uint32_t cad_wait = cad_busy_start ? _ms->getMillis() - cad_busy_start : 0;
+#endif
   cad_busy_start = 0;  // reset busy state
 
-  outbound = _mgr->getNextOutbound(_ms->getMillis());
+  if (held_outbound) {
+    outbound = held_outbound;   // must go first, is already out of the queue
+    held_outbound = NULL;
+  } else {
+    outbound = _mgr->getNextOutbound(_ms->getMillis());
+  #if MESH_LATENCY_STATS
+    if (outbound) {
+      uint32_t late = _ms->getMillis() - outbound->_lat_stamp;
+      _latency.record(LAT_STAGE_TX_QUEUE, LatencyHistograms::getKey(outbound), (int32_t)late > 0 ? late : 0);
+    }
+  #endif
+  }
   if (outbound) {
-    int len = 0;
+    int len = outbound->getRawLength();
     uint8_t raw[MAX_TRANS_UNIT];
 
-    raw[len++] = outbound->header;
-    if (outbound->hasTransportCodes()) {
-      memcpy(&raw[len], &outbound->transport_codes[0], 2); len += 2;
-      memcpy(&raw[len], &outbound->transport_codes[1], 2); len += 2;
-    }
-    raw[len++] = outbound->path_len;
-    len += Packet::writePath(&raw[len], outbound->path, outbound->path_len);
-
-    if (len + outbound->payload_len > MAX_TRANS_UNIT) {
-      MESH_DEBUG_PRINTLN("%s Dispatcher::checkSend(): FATAL: Invalid packet queued... too long, len=%d", getLogDateTime(), len + outbound->payload_len);
-      _mgr->free(outbound);
+    if (len > MAX_TRANS_UNIT) {   // check before serialising, so can't overrun raw[]
+      MESH_DEBUG_PRINTLN("%s Dispatcher::checkSend(): FATAL: Invalid packet queued... too long, len=%d", getLogDateTime(), len);
+      releasePacket(outbound);
       outbound = NULL;
     } else {
-      memcpy(&raw[len], outbound->payload, outbound->payload_len); len += outbound->payload_len;
+      const uint8_t* frame = getForwardFrame(outbound);
+      if (frame == NULL) {
+        len = outbound->writeTo(raw);   // single pass over header, path and payload
+        frame = raw;
+      }
+
+      uint32_t dc_delay;
+      if (!getTxDutyCycleDelay(_radio->getEstAirtimeFor(len), dc_delay)) {
+        MESH_DEBUG_PRINTLN("%s Dispatcher::checkSend(): ERROR: packet airtime exceeds duty-cycle limit, len=%d", getLogDateTime(), len);
+        logTxFail(outbound, len);
+        releasePacket(outbound);  // return to pool
+        outbound = NULL;
+        return;
+      }
+      if (dc_delay > 0) {
+        held_outbound = outbound;   // hold on to it until the duty-cycle limit allows
+        outbound = NULL;
+        next_tx_time = futureMillis(dc_delay);
+        return;
+      }
+
+      MESH_LATENCY_RECORD(LAT_STAGE_TX_CAD, LatencyHistograms::getKey(outbound), cad_wait);
 
       uint32_t max_airtime = _radio->getEstAirtimeFor(len)*3/2;
       outbound_start = _ms->getMillis();
-      bool success = _radio->startSendRaw(raw, len);
+      bool success = _radio->startSendRaw(frame, len);
+      releaseRecvFrame(outbound);   // NOTE: radio has its own copy now
       if (!success) {
         MESH_DEBUG_PRINTLN("%s Dispatcher::loop(): ERROR: send start failed!", getLogDateTime());
 
@@ -359,11 +667,13 @@ Packet* Dispatcher::obtainNewPacket() {
   } else {
     pkt->payload_len = pkt->path_len = 0;
     pkt->_snr = 0;
+    releaseRecvFrame(pkt);   // in case pkt was freed without releasePacket()
   }
   return pkt;
 }
 
 void Dispatcher::releasePacket(Packet* packet) {
+  releaseRecvFrame(packet);
   _mgr->free(packet);
 }
 
@@ -372,10 +682,110 @@ void Dispatcher::sendPacket(Packet* packet, uint8_t priority, uint32_t delay_mil
     MESH_DEBUG_PRINTLN("%s Dispatcher::sendPacket(): ERROR: invalid packet... path_len=%d, payload_len=%d", getLogDateTime(), (uint32_t) packet->path_len, (uint32_t) packet->payload_len);
     _mgr->free(packet);
   } else {
+  #if MESH_LATENCY_STATS
+    _latency.record(LAT_STAGE_TX_DELAY, LatencyHistograms::getKey(packet), delay_millis);
+    packet->_lat_stamp = futureMillis(delay_millis);
+  #endif
     _mgr->queueOutbound(packet, priority, futureMillis(delay_millis));
   }
 }
 
+void ChannelUtilisation::reset(uint32_t now) {
+  memset(_slots, 0, sizeof(_slots));
+  _slot_start = now;
+  _cur = 0;
+}
+
+void ChannelUtilisation::advance(uint32_t now) {
+  int n = 0;
+  while (now - _slot_start >= CHANNEL_UTIL_SLOT_MILLIS) {
+    _slot_start += CHANNEL_UTIL_SLOT_MILLIS;
+    if (n++ < CHANNEL_UTIL_NUM_SLOTS) {   // after a long gap, only need to clear each slot once
+      _cur = (_cur + 1) % CHANNEL_UTIL_NUM_SLOTS;
+      memset(&_slots[_cur], 0, sizeof(Slot));
+    }
+  }
+}
+
+void ChannelUtilisation::addBusy(uint32_t now, uint32_t millis) {
+  advance(now);
+  uint32_t in_slot = now - _slot_start;   // the part of current slot already elapsed
+  for (int i = 0; i < CHANNEL_UTIL_NUM_SLOTS && millis > 0; i++) {
+    auto slot = &_slots[(_cur + CHANNEL_UTIL_NUM_SLOTS - i) % CHANNEL_UTIL_NUM_SLOTS];
+    uint32_t t = millis < in_slot ? millis : in_slot;
+    slot->busy_millis += t;
+    if (slot->busy_millis > CHANNEL_UTIL_SLOT_MILLIS) slot->busy_millis = CHANNEL_UTIL_SLOT_MILLIS;
+    millis -= t;
+    in_slot = CHANNEL_UTIL_SLOT_MILLIS;   // older slots are whole
+  }
+}
+
+void ChannelUtilisation::addSample(uint32_t now, bool is_busy) {
+  advance(now);
+  auto slot = &_slots[_cur];
+  if (slot->n_samples < 255) {
+    slot->n_samples++;
+    if (is_busy) slot->n_busy++;
+  }
+}
+
+uint16_t ChannelUtilisation::getPermille(uint32_t now, uint32_t window_millis) {
+  advance(now);
+  uint32_t busy = 0, elapsed = now - _slot_start;
+  uint32_t n_samples = 0, n_busy = 0;
+  int n = (window_millis + CHANNEL_UTIL_SLOT_MILLIS - 1) / CHANNEL_UTIL_SLOT_MILLIS;
+  if (n > CHANNEL_UTIL_NUM_SLOTS) n = CHANNEL_UTIL_NUM_SLOTS;
+  for (int i = 0; i < n; i++) {
+    auto slot = &_slots[(_cur + CHANNEL_UTIL_NUM_SLOTS - i) % CHANNEL_UTIL_NUM_SLOTS];
+    busy += slot->busy_millis;
+    n_samples += slot->n_samples;
+    n_busy += slot->n_busy;
+  }
+  elapsed += (n - 1) * CHANNEL_UTIL_SLOT_MILLIS;
+
+  uint32_t util = elapsed > 0 ? busy * 1000 / elapsed : 0;
+  if (n_samples >= 4 && n_busy * 1000 / n_samples > util) {   // too few samples are just noise
+    util = n_busy * 1000 / n_samples;
+  }
+  return util > 1000 ? 1000 : util;
+}
+
+#if MESH_LATENCY_STATS
+int LatencyHistograms::getBucket(uint32_t value) {
+  int b = 0;
+  while (value > 0 && b < LAT_NUM_BUCKETS - 1) {
+    value >>= 1;
+    b++;
+  }
+  return b;
+}
+
+void LatencyHistograms::record(uint8_t stage, uint8_t key, uint32_t value) {
+  int i = 0;
+  while (i < _num && (_hists[i].stage != stage || _hists[i].key != key)) i++;
+  if (i == _num) {
+    if (_num >= LAT_MAX_HISTOGRAMS) {
+      _n_dropped++;
+      return;
+    }
+    memset(&_hists[i], 0, sizeof(_hists[i]));
+    _hists[i].stage = stage;
+    _hists[i].key = key;
+    _num++;
+  }
+  auto h = &_hists[i];
+  int b = getBucket(value);
+  if (h->counts[b] < 0xFFFF) h->counts[b]++;
+  h->total = (value > 0xFFFFFFFF - h->total) ? 0xFFFFFFFF : h->total + value;
+}
+
+void LatencyHistograms::reset() {
+  _num = 0;
+  _n_dropped = 0;
+  crypto_micros = 0;
+}
+#endif
+
 // Utility function -- handles the case where millis() wraps around back to zero
 //   2's complement arithmetic will handle any unsigned subtraction up to HALF the word size (32-bits in this case)
 bool Dispatcher::millisHasNowPassed(unsigned long timestamp) const {
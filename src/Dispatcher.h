@@ -14,6 +14,7 @@ namespace mesh {
 class MillisecondClock {
 public:
   virtual unsigned long getMillis() = 0;
+  virtual unsigned long getMicros() { return getMillis() * 1000; }   // only used for latency stats
 };
 
 /**
@@ -76,8 +77,143 @@ public:
 
   virtual float getLastRSSI() const { return 0; }
   virtual float getLastSNR() const { return 0; }
+
+  /**
+   * \returns  true if radio has work which needs loop()/recvRaw() to be called straight away (eg. a received packet
+   *         waiting, or noise floor sampling in progress), so the MCU should not sleep yet.
+   *         NOTE: defaults to true, ie. radio never allows sleep unless it overrides this.
+  */
+  virtual bool needsPolling() const { return true; }
+};
+
+/**
+ * \brief  Occupancy telemetry for a Packet pool.
+*/
+struct PacketPoolStats {
+  uint16_t pool_size;
+  uint16_t num_free;
+  uint16_t max_in_use;      // high-water mark
+  uint32_t n_alloc_fails;
+  uint32_t empty_millis;    // total time spent with zero free Packets
+  uint32_t n_bad_frees;     // foreign or double frees (only detected with PACKET_POOL_DEBUG)
+};
+
+#define TX_CLASS_ACK       0   // ACKs
+#define TX_CLASS_DIRECT    1   // other direct routed traffic
+#define TX_CLASS_FLOOD     2   // flood traffic (originated or relayed), except adverts
+#define TX_CLASS_BULK      3   // adverts and TRACE
+#define NUM_TX_CLASSES     4
+
+/**
+ * \brief  Outbound queueing telemetry, per traffic class (see TX_CLASS_*)
+*/
+struct TxClassStats {
+  uint32_t n_sent;
+  uint32_t total_wait_millis;   // sum of time spent queued after being due
+  uint32_t max_wait_millis;
+  uint32_t n_starved;           // number dequeued after waiting longer than the starvation limit
+};
+
+#define CHANNEL_UTIL_SLOT_MILLIS   1000
+#define CHANNEL_UTIL_NUM_SLOTS       64
+
+/**
+ * \brief  Sliding window estimate of how busy the channel is with other nodes' traffic, kept in 1 second slots.
+ *        Built from the airtime of all overheard frames (even ones which fail to parse), and from CAD/isReceiving()
+ *        samples, which also catch frames that are never received (eg. CRC errors, or too weak to decode).
+*/
+class ChannelUtilisation {
+  struct Slot {
+    uint16_t busy_millis;
+    uint8_t n_samples, n_busy;
+  };
+  Slot _slots[CHANNEL_UTIL_NUM_SLOTS];
+  uint32_t _slot_start;   // millis, start of current slot
+  int _cur;
+
+  void advance(uint32_t now);
+
+public:
+  void reset(uint32_t now);
+  void addBusy(uint32_t now, uint32_t millis);   // channel was busy for 'millis', up to 'now'
+  void addSample(uint32_t now, bool is_busy);
+
+  /**
+   * \returns  estimated utilisation (permille) over the last 'window_millis' (max 64 seconds), ie. the greater of
+   *          the airtime based and the sample based estimates.
+  */
+  uint16_t getPermille(uint32_t now, uint32_t window_millis);
+};
+
+#ifndef FLOOD_SUPPRESS_TRACKED
+  #define FLOOD_SUPPRESS_TRACKED   8    // max queued rebroadcasts with duplicates being counted
+#endif
+#define FLOOD_DUP_WEIGHT_ONE       4    // weight of one duplicate, when not SNR weighted
+
+#ifndef RECV_FRAME_POOL_SIZE
+  #define RECV_FRAME_POOL_SIZE     0    // received frames kept with their Packet (getRecvFrame(), cut-through forwarding), 0 = off
+#endif
+
+#define LAT_STAGE_RX_PARSE     0   // raw bytes into Packet (micros)
+#define LAT_STAGE_RX_DELAY     1   // time in the delayed inbound queue (millis)
+#define LAT_STAGE_RX_PROCESS   2   // onRecvPacket(), incl. crypto and app handlers (micros)
+#define LAT_STAGE_RX_CRYPTO    3   // signature verify, shared secret, MAC check + decrypt, per packet (micros)
+#define LAT_STAGE_TX_DELAY     4   // requested retransmit/send delay (millis)
+#define LAT_STAGE_TX_QUEUE     5   // from due time until dequeued for send, incl. budget and CAD waits (millis)
+#define LAT_STAGE_TX_CAD       6   // channel busy (CAD) deferral just before transmit (millis)
+#define LAT_STAGE_TX_AIRTIME   7   // (millis)
+#define NUM_LAT_STAGES         8
+
+#if MESH_LATENCY_STATS
+
+#ifndef LAT_MAX_HISTOGRAMS
+  #define LAT_MAX_HISTOGRAMS   48    // max (stage, payload type, route type) combinations tracked
+#endif
+#define LAT_NUM_BUCKETS        16    // bucket 0: value 0, bucket b: [2^(b-1), 2^b), last bucket: >= 2^14
+
+/**
+ * \brief  Log2 bucketed histogram, for one pipeline stage of one kind of Packet.
+*/
+struct LatencyHistogram {
+  uint8_t stage;      // LAT_STAGE_*
+  uint8_t key;        // Packet::header, less the version bits, ie. (payload_type << 2) | route_type
+  uint16_t counts[LAT_NUM_BUCKETS];   // saturating
+  uint32_t total;     // sum of values (saturating), for the mean
+};
+
+/**
+ * \brief  Fixed size set of LatencyHistograms, allocated on first use of each (stage, key).
+*/
+class LatencyHistograms {
+  LatencyHistogram _hists[LAT_MAX_HISTOGRAMS];
+  int _num;
+  uint32_t _n_dropped;   // samples not recorded, as all histograms in use
+
+public:
+  uint32_t crypto_micros;   // accumulated by Mesh while processing current packet
+
+  LatencyHistograms() { reset(); }
+
+  static int getBucket(uint32_t value);
+  static uint8_t getKey(const Packet* packet) { return packet->header & (PH_ROUTE_MASK | (PH_TYPE_MASK << PH_TYPE_SHIFT)); }
+
+  void record(uint8_t stage, uint8_t key, uint32_t value);
+  void reset();
+
+  int getCount() const { return _num; }
+  const LatencyHistogram* getByIdx(int i) const { return i >= 0 && i < _num ? &_hists[i] : NULL; }
+  uint32_t getNumDropped() const { return _n_dropped; }
 };
 
+  #define MESH_LATENCY_START(t)                 unsigned long t = _ms->getMicros()
+  #define MESH_LATENCY_RECORD(stage, key, value)   _latency.record(stage, key, value)
+  #define MESH_LATENCY_CRYPTO(t)                _latency.crypto_micros += _ms->getMicros() - (t)
+#else
+  #define MESH_LATENCY_START(t)                 {}
+  #define MESH_LATENCY_RECORD(stage, key, value)   {}
+  #define MESH_LATENCY_CRYPTO(t)                {}
+#endif
+
 /**
  * \brief  An abstraction for managing instances of Packets (eg. in a static pool),
  *        and for managing the outbound packet queue.
@@ -96,6 +232,26 @@ public:
   virtual Packet* removeOutboundByIdx(int i) = 0;
   virtual void queueInbound(Packet* packet, uint32_t scheduled_for) = 0;
   virtual Packet* getNextInbound(uint32_t now) = 0;
+
+  virtual bool getPoolStats(PacketPoolStats& dest) const { return false; }   // not supported by default
+  virtual void resetPoolStats() { }
+
+  /**
+   * \brief  configures an outbound scheduler which shares airtime between the traffic classes (if supported)
+   * \param  weights  NUM_TX_CLASSES relative weights (indexed by TX_CLASS_*). A weight of 0 makes that class strict priority.
+  */
+  virtual bool setTxClassWeights(const uint8_t weights[]) { return false; }   // not supported by default
+  virtual bool getTxClassStats(int tx_class, TxClassStats& dest) const { return false; }
+  virtual void resetTxClassStats() { }
+
+  /**
+   * \brief  finds the earliest 'scheduled_for' time of the queued outbound/inbound Packets. Entries which are already
+   *        due may report any time up to 'now'.
+   * \returns false if queue is empty.
+   *        NOTE: defaults just assume something is due 'now', so the Dispatcher never sleeps past queued work.
+  */
+  virtual bool getNextOutboundTime(uint32_t now, uint32_t& scheduled_for) const { scheduled_for = now; return getOutboundTotal() > 0; }
+  virtual bool getNextInboundTime(uint32_t now, uint32_t& scheduled_for) const { scheduled_for = now; return true; }
 };
 
 typedef uint32_t  DispatcherAction;
@@ -115,9 +271,30 @@ typedef uint32_t  DispatcherAction;
 */
 class Dispatcher {
   Packet* outbound;  // current outbound packet
+  Packet* held_outbound;  // next outbound packet, held back by a duty-cycle limit
   unsigned long outbound_expiry, outbound_start, total_air_time, rx_air_time;
   unsigned long next_tx_time;
   unsigned long cad_busy_start;
+  uint8_t cad_busy_count;     // consecutive busy CAD checks, for current send
+  uint16_t cad_backoff_util;  // channel utilisation (permille) when backoff was calculated
+  uint32_t n_forced_sends;
+  ChannelUtilisation channel_util;
+  struct FloodDupCount {
+    uint8_t hash[MAX_HASH_SIZE];   // Packet::calculateDedupeHash() of queued rebroadcast
+    uint8_t weight;                // sum of duplicates heard, in FLOOD_DUP_WEIGHT_ONE units
+  };
+  FloodDupCount dup_counts[FLOOD_SUPPRESS_TRACKED];
+  uint8_t next_dup_count;
+  struct RecvFrame {
+    const Packet* owner;   // NULL = free
+    uint8_t start, len;    // the wire image is buf[start] .. buf[start + len - 1]
+    bool is_forward;       // wire image has been updated by forwardRecvFrame(), is kept until sent
+    uint8_t buf[MAX_TRANS_UNIT+1];
+  };
+#if RECV_FRAME_POOL_SIZE > 0
+  RecvFrame recv_frames[RECV_FRAME_POOL_SIZE];
+#endif
+  uint32_t n_flood_suppressed, flood_suppressed_air_time;
   unsigned long radio_nonrx_start;
   unsigned long next_floor_calib_time, next_agc_reset_time;
   bool  prev_isrecv_mode;
@@ -126,23 +303,45 @@ class Dispatcher {
   unsigned long tx_budget_ms;
   unsigned long last_budget_update;
   unsigned long duty_cycle_window_ms;
+  float budget_factor;        // getAirtimeBudgetFactor() that duty_cycle was calculated for
+  uint32_t duty_cycle;        // 1 / (1 + budget_factor), in 8.24 fixed point
 
   void processRecvPacket(Packet* pkt);
+  RecvFrame* findRecvFrame(const Packet* pkt);
+  void releaseRecvFrame(const Packet* pkt);
+  const uint8_t* getForwardFrame(const Packet* pkt);
+  FloodDupCount* findFloodDupCount(const uint8_t* hash);
+  void trackFloodRebroadcast(const Packet* pkt);
+  void checkFloodSuppress(const Packet* dup);
   void updateTxBudget();
+  uint32_t getDutyCycle();
+  unsigned long calcBudgetWait(unsigned long needed);
 
 protected:
   PacketManager* _mgr;
   Radio* _radio;
   MillisecondClock* _ms;
   uint16_t _err_flags;
+#if MESH_LATENCY_STATS
+  LatencyHistograms _latency;
+#endif
 
   Dispatcher(Radio& radio, MillisecondClock& ms, PacketManager& mgr)
     : _radio(&radio), _ms(&ms), _mgr(&mgr)
   {
-    outbound = NULL;
+    outbound = held_outbound = NULL;
     total_air_time = rx_air_time = 0;
     next_tx_time = ms.getMillis();
     cad_busy_start = 0;
+    cad_busy_count = 0;
+    cad_backoff_util = 0;
+    n_forced_sends = 0;
+    memset(dup_counts, 0, sizeof(dup_counts));
+    next_dup_count = 0;
+  #if RECV_FRAME_POOL_SIZE > 0
+    for (int i = 0; i < RECV_FRAME_POOL_SIZE; i++) recv_frames[i].owner = NULL;
+  #endif
+    n_flood_suppressed = flood_suppressed_air_time = 0;
     next_floor_calib_time = next_agc_reset_time = 0;
     _err_flags = 0;
     radio_nonrx_start = 0;
@@ -150,10 +349,33 @@ protected:
     tx_budget_ms = 0;
     last_budget_update = 0;
     duty_cycle_window_ms = 3600000;
+    budget_factor = -1.0f;   // not calculated yet
+    duty_cycle = 0;
   }
 
   virtual DispatcherAction onRecvPacket(Packet* pkt) = 0;
 
+  /**
+   * \brief  carries out what onRecvPacket() returned, for a Packet the sub-class held (ACTION_MANUAL_HOLD) and
+   *        has now finished with, ie. frees it or queues it for retransmit.
+   */
+  void applyRecvAction(Packet* pkt, DispatcherAction action);
+
+  /**
+   * \brief  the frame 'pkt' was parsed from, exactly as received (ie. without re-serialising with writeTo()). Only
+   *        available during onRecvPacket(), for Packets which are processed straight away (not delayed).
+   * \returns  NULL if not available (eg. all frame buffers were in use, or RECV_FRAME_POOL_SIZE is 0)
+   */
+  const uint8_t* getRecvFrame(const Packet* pkt, int& len);
+
+  /**
+   * \brief  cut-through forwarding: updates the received frame of 'pkt' in-place with its (already shortened) path,
+   *        so that checkSend() transmits those bytes instead of re-serialising the Packet.
+   *        Call after removing this node from the path of a direct Packet, and before returning ACTION_RETRANSMIT*.
+   * \returns  false if the received frame isn't available (Packet will be sent as normal)
+   */
+  bool forwardRecvFrame(const Packet* pkt);
+
   virtual void logRxRaw(float snr, float rssi, const uint8_t raw[], int len) { }   // custom hook
 
   virtual void logRx(Packet* packet, int len, float score) { }   // hooks for custom logging
@@ -163,16 +385,53 @@ protected:
 
   virtual float getAirtimeBudgetFactor() const;
   virtual int calcRxDelay(float score, uint32_t air_time) const;
+
+  /**
+   * \returns  (base ^ (0.85 - score) - 1) * air_time, ie. the usual calcRxDelay() formula, in fixed point
+   */
+  static int calcScoreDelay(float base, float score, uint32_t air_time);
   virtual uint32_t getCADFailRetryDelay() const;
   virtual uint32_t getCADFailMaxDuration() const;
+
+  /**
+   * \returns  a random number in [0, _max), for the CAD backoff. (default has no randomness)
+   */
+  virtual uint32_t nextRandomInt(uint32_t _max) const { return _max / 2; }
   virtual int getInterferenceThreshold() const { return 0; }    // disabled by default
   virtual int getAGCResetInterval() const { return 0; }    // disabled by default
   virtual unsigned long getDutyCycleWindowMs() const { return 3600000; }
 
+  /**
+   * \returns  number of duplicates to hear of a flood packet, while this node's rebroadcast of it is still queued,
+   *          before that rebroadcast is cancelled. 0 = never cancel (default)
+   */
+  virtual uint8_t getFloodSuppressThreshold() const { return 0; }
+
+  /**
+   * \returns  true if duplicates with weak SNR should count for less (as their sender is further away, and
+   *          so likely covers fewer of this node's neighbours)
+   */
+  virtual bool isFloodSuppressSNRWeighted() const { return false; }
+
+  /**
+   * \brief  hook for enforcing regulatory (eg. per sub-band) duty-cycle limits, on top of the airtime budget
+   * \param  delay_millis  (OUT) millis until a transmit of 'airtime' is allowed (0 = now)
+   * \returns false if a transmit of 'airtime' can never be allowed
+   */
+  virtual bool getTxDutyCycleDelay(uint32_t airtime, uint32_t& delay_millis) { delay_millis = 0; return true; }   // no limits by default
+  virtual void onTxAirtime(unsigned long start, uint32_t airtime) { }   // called after each completed transmit
+
 public:
   void begin();
   void loop();
 
+  /**
+   * \returns  millis until the earliest timed event that loop() needs to service (inbound/outbound queues, TX timeout,
+   *        duty-cycle/CAD backoff, AGC reset, etc), capped at 'max_millis'. 0 means loop() should be called again now.
+   *        Until this deadline, only a radio interrupt can create new work, so the board is free to sleep.
+  */
+  virtual uint32_t getMillisToNextEvent(uint32_t max_millis) const;
+
   Packet* obtainNewPacket();
   void releasePacket(Packet* packet);
   void sendPacket(Packet* packet, uint8_t priority, uint32_t delay_millis=0);
@@ -184,10 +443,24 @@ public:
   uint32_t getNumSentDirect() const { return n_sent_direct; }
   uint32_t getNumRecvFlood() const { return n_recv_flood; }
   uint32_t getNumRecvDirect() const { return n_recv_direct; }
+  uint32_t getNumForcedSends() const { return n_forced_sends; }   // sent while channel still busy, after max CAD duration
+  uint32_t getNumFloodSuppressed() const { return n_flood_suppressed; }   // queued rebroadcasts cancelled, see getFloodSuppressThreshold()
+  uint32_t getFloodSuppressedAirTime() const { return flood_suppressed_air_time; }   // est. airtime saved (millis)
+
+  /**
+   * \returns  estimated channel utilisation by other nodes (permille), over the last 'window_millis' (max 64 seconds)
+   */
+  uint16_t getChannelUtilisation(uint32_t window_millis) { return channel_util.getPermille(_ms->getMillis(), window_millis); }
   void resetStats() {
     n_sent_flood = n_sent_direct = n_recv_flood = n_recv_direct = 0;
+    n_forced_sends = 0;
+    n_flood_suppressed = flood_suppressed_air_time = 0;
     _err_flags = 0;
   }
+#if MESH_LATENCY_STATS
+  const LatencyHistograms& getLatencyStats() const { return _latency; }
+  void resetLatencyStats() { _latency.reset(); }
+#endif
 
   // helper methods
   bool millisHasNowPassed(unsigned long timestamp) const;
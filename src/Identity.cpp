@@ -140,4 +140,44 @@ void LocalIdentity::calcSharedSecret(uint8_t* secret, const uint8_t* other_pub_k
   ed25519_key_exchange(secret, other_pub_key, prv_key);
 }
 
+SharedSecretCache::SharedSecretCache() {
+  memset(_self_pub_key, 0, sizeof(_self_pub_key));
+  _num = 0;
+  _hits = _misses = 0;
+}
+
+void SharedSecretCache::clear() {
+  memset(_entries, 0, sizeof(_entries));
+  _num = 0;
+}
+
+void SharedSecretCache::calcSharedSecret(uint8_t* secret, const LocalIdentity& self_id, const uint8_t* other_pub_key) {
+  memcpy(secret, getSharedSecret(self_id, other_pub_key), PUB_KEY_SIZE);
+}
+
+const uint8_t* SharedSecretCache::getSharedSecret(const LocalIdentity& self_id, const uint8_t* other_pub_key) {
+  if (!self_id.matches(_self_pub_key)) {   // identity changed (or first use)
+    clear();
+    memcpy(_self_pub_key, self_id.pub_key, PUB_KEY_SIZE);
+  }
+
+  int i = 0;
+  while (i < _num && memcmp(_entries[i].pub_key, other_pub_key, PUB_KEY_SIZE) != 0) i++;
+
+  Entry e;
+  if (i < _num) {
+    _hits++;
+    e = _entries[i];
+  } else {
+    _misses++;
+    memcpy(e.pub_key, other_pub_key, PUB_KEY_SIZE);
+    self_id.calcSharedSecret(e.secret, other_pub_key);
+    if (_num < SHARED_SECRET_CACHE_SIZE) _num++;
+    i = _num - 1;   // replaces least recently used, if full
+  }
+  memmove(&_entries[1], &_entries[0], i * sizeof(Entry));   // move to front
+  _entries[0] = e;
+  return _entries[0].secret;
+}
+
 }
\ No newline at end of file
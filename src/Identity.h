@@ -94,5 +94,46 @@ public:
   void readFrom(const uint8_t* src, size_t len);
 };
 
+#ifndef SHARED_SECRET_CACHE_SIZE
+  #define SHARED_SECRET_CACHE_SIZE   8
+#endif
+
+/**
+ * \brief  A small LRU cache of ECDH shared secrets, by peer public key, so that a peer which keeps sending
+ *        (eg. retrying a login, or repeated anonymous requests) doesn't cost a key exchange each time.
+ *        Secrets are wiped when used with a different LocalIdentity (ie. this node's identity changed).
+*/
+class SharedSecretCache {
+  struct Entry {
+    uint8_t pub_key[PUB_KEY_SIZE];
+    uint8_t secret[PUB_KEY_SIZE];
+  };
+  Entry _entries[SHARED_SECRET_CACHE_SIZE];   // most recently used first
+  int _num;
+  uint8_t _self_pub_key[PUB_KEY_SIZE];        // identity the secrets were calculated with
+  uint32_t _hits, _misses;
+
+public:
+  SharedSecretCache();
+
+  /**
+   * \brief  same as self_id.calcSharedSecret(), but from the cache if possible
+   * \param  secret OUT - the 'shared secret' (must be PUB_KEY_SIZE bytes)
+  */
+  void calcSharedSecret(uint8_t* secret, const LocalIdentity& self_id, const uint8_t* other_pub_key);
+  void calcSharedSecret(uint8_t* secret, const LocalIdentity& self_id, const Identity& other) { calcSharedSecret(secret, self_id, other.pub_key); }
+
+  /**
+   * \returns  the 'shared secret' with 'other_pub_key', from the cache if possible. NOTE: is only valid until the next call
+  */
+  const uint8_t* getSharedSecret(const LocalIdentity& self_id, const uint8_t* other_pub_key);
+
+  void clear();   // wipes all secrets
+
+  uint32_t getNumHits() const { return _hits; }
+  uint32_t getNumMisses() const { return _misses; }
+  void resetStats() { _hits = _misses = 0; }
+};
+
 }
 
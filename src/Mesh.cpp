@@ -5,10 +5,50 @@ namespace mesh {
 
 void Mesh::begin() {
   Dispatcher::begin();
+#if MESH_FAST_DEDUPE_HASH
+  uint8_t key[16];
+  _rng->random(key, sizeof(key));   // new secret each boot, so others can't craft colliding packets
+  Packet::setDedupeHashKey(key);
+#endif
 }
 
 void Mesh::loop() {
   Dispatcher::loop();
+  checkPendingAdverts();
+}
+
+uint32_t Mesh::getMillisToNextEvent(uint32_t max_millis) const {
+#if MESH_ADVERT_VERIFY_QUEUE > 0
+  if (_num_pending_adverts > 0) return 0;   // still adverts to check
+#endif
+  return Dispatcher::getMillisToNextEvent(max_millis);
+}
+
+void Mesh::checkPendingAdverts() {
+#if MESH_ADVERT_VERIFY_QUEUE > 0
+  if (_num_pending_adverts == 0) return;
+
+  // just one per loop(), so a burst of adverts can't keep the radio (rx and tx) waiting for long
+  Packet* pkt = _pending_adverts[0].pkt;
+  uint32_t wait = _ms->getMillis() - _pending_adverts[0].queued_at;
+  _num_pending_adverts--;
+  memmove(&_pending_adverts[0], &_pending_adverts[1], _num_pending_adverts * sizeof(PendingAdvert));
+  _advert_stats.depth = _num_pending_adverts;
+
+  _advert_stats.n_deferred++;
+  _advert_stats.total_wait_millis += wait;
+  if (wait > _advert_stats.max_wait_millis) _advert_stats.max_wait_millis = wait;
+
+#if MESH_LATENCY_STATS
+  uint8_t key = LatencyHistograms::getKey(pkt);   // NOTE: pkt may be modified by routeRecvPacket()
+  _latency.crypto_micros = 0;
+#endif
+  DispatcherAction action = processAdvert(pkt);
+#if MESH_LATENCY_STATS
+  _latency.record(LAT_STAGE_RX_CRYPTO, key, _latency.crypto_micros);
+#endif
+  applyRecvAction(pkt, action);
+#endif
 }
 
 bool Mesh::allowPacketForward(const mesh::Packet* packet) { 
@@ -26,8 +66,8 @@ uint8_t Mesh::getExtraAckTransmitCount() const {
   return 0;
 }
 
-uint32_t Mesh::getCADFailRetryDelay() const {
-  return _rng->nextInt(1, 4)*120;
+uint32_t Mesh::nextRandomInt(uint32_t _max) const {
+  return _rng->nextInt(0, _max);
 }
 
 int Mesh::searchPeersByHash(const uint8_t* hash) {
@@ -96,6 +136,7 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
 
       if (!_tables->hasSeen(pkt)) {
         removeSelfFromPath(pkt);
+        forwardRecvFrame(pkt);   // send the received bytes as-is, with just the path updated
 
         uint32_t d = getDirectRetransmitDelay(pkt);
         return ACTION_RETRANSMIT_DELAYED(0, d);  // Routed traffic is HIGHEST priority 
@@ -143,12 +184,14 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
           // for each matching contact, try to decrypt data
           bool found = false;
           for (int j = 0; j < num; j++) {
+            MESH_LATENCY_START(t_crypto);
             uint8_t secret[PUB_KEY_SIZE];
             getPeerSharedSecret(secret, j);
 
             // decrypt, checking MAC is valid
             uint8_t data[MAX_PACKET_PAYLOAD];
-            int len = Utils::MACThenDecrypt(secret, data, macAndData, pkt->payload_len - i);
+            int len = Utils::MACThenDecrypt(getCryptoContext(secret), data, macAndData, pkt->payload_len - i);
+            MESH_LATENCY_CRYPTO(t_crypto);
             if (len > 0) {  // success!
               if (pkt->getPayloadType() == PAYLOAD_TYPE_PATH) {
                 int k = 0;
@@ -195,12 +238,14 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
         if (self_id.isHashMatch(&dest_hash)) {
           Identity sender(sender_pub_key);
 
+          MESH_LATENCY_START(t_crypto);
           uint8_t secret[PUB_KEY_SIZE];
-          self_id.calcSharedSecret(secret, sender);
+          calcSharedSecret(secret, sender);   // often a client retrying a login, so is cached
 
           // decrypt, checking MAC is valid
           uint8_t data[MAX_PACKET_PAYLOAD];
-          int len = Utils::MACThenDecrypt(secret, data, macAndData, pkt->payload_len - i);
+          int len = Utils::MACThenDecrypt(getCryptoContext(secret), data, macAndData, pkt->payload_len - i);
+          MESH_LATENCY_CRYPTO(t_crypto);
           if (len > 0) {  // success!
             onAnonDataRecv(pkt, secret, sender, data, len);
             pkt->markDoNotRetransmit();
@@ -225,8 +270,10 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
         // for each matching channel, try to decrypt data
         for (int j = 0; j < num; j++) {
           // decrypt, checking MAC is valid
+          MESH_LATENCY_START(t_crypto);
           uint8_t data[MAX_PACKET_PAYLOAD];
-          int len = Utils::MACThenDecrypt(channels[j].secret, data, macAndData, pkt->payload_len - i);
+          int len = Utils::MACThenDecrypt(getChannelCryptoContext(channels[j]), data, macAndData, pkt->payload_len - i);
+          MESH_LATENCY_CRYPTO(t_crypto);
           if (len > 0) {  // success!
             onGroupDataRecv(pkt, pkt->getPayloadType(), channels[j], data, len);
             break;
@@ -237,41 +284,25 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
       break;
     }
     case PAYLOAD_TYPE_ADVERT: {
-      int i = 0;
-      Identity id;
-      memcpy(id.pub_key, &pkt->payload[i], PUB_KEY_SIZE); i += PUB_KEY_SIZE;
-
-      uint32_t timestamp;
-      memcpy(&timestamp, &pkt->payload[i], 4); i += 4;
-      const uint8_t* signature = &pkt->payload[i]; i += SIGNATURE_SIZE;
-
-      if (i > pkt->payload_len) {
+      if (PUB_KEY_SIZE + 4 + SIGNATURE_SIZE > pkt->payload_len) {   // pub_key, timestamp, signature
         MESH_DEBUG_PRINTLN("%s Mesh::onRecvPacket(): incomplete advertisement packet", getLogDateTime());
-      } else if (self_id.matches(id.pub_key)) {
+      } else if (self_id.matches(pkt->payload)) {
         MESH_DEBUG_PRINTLN("%s Mesh::onRecvPacket(): receiving SELF advert packet", getLogDateTime());
       } else if (!_tables->hasSeen(pkt)) {
-        uint8_t* app_data = &pkt->payload[i];
-        int app_data_len = pkt->payload_len - i;
-        if (app_data_len > MAX_ADVERT_DATA_SIZE) { app_data_len = MAX_ADVERT_DATA_SIZE; }
-
-        // check that signature is valid
-        bool is_ok;
-        {
-          uint8_t message[PUB_KEY_SIZE + 4 + MAX_ADVERT_DATA_SIZE];
-          int msg_len = 0;
-          memcpy(&message[msg_len], id.pub_key, PUB_KEY_SIZE); msg_len += PUB_KEY_SIZE;
-          memcpy(&message[msg_len], &timestamp, 4); msg_len += 4;
-          memcpy(&message[msg_len], app_data, app_data_len); msg_len += app_data_len;
-
-          is_ok = id.verify(signature, message, msg_len);
-        }
-        if (is_ok) {
-          MESH_DEBUG_PRINTLN("%s Mesh::onRecvPacket(): valid advertisement received!", getLogDateTime());
-          onAdvertRecv(pkt, id, timestamp, app_data, app_data_len);
-          action = routeRecvPacket(pkt);
-        } else {
-          MESH_DEBUG_PRINTLN("%s Mesh::onRecvPacket(): received advertisement with forged signature! (app_data_len=%d)", getLogDateTime(), app_data_len);
+      #if MESH_ADVERT_VERIFY_QUEUE > 0
+        if (!_verify_adverts_now) {
+          // NOTE: small pools (eg. SlabPacketManager) could be run dry by held adverts
+          if (_num_pending_adverts < MESH_ADVERT_VERIFY_QUEUE && _mgr->getFreeCount() > MESH_ADVERT_VERIFY_RESERVE) {
+            _pending_adverts[_num_pending_adverts].pkt = pkt;
+            _pending_adverts[_num_pending_adverts].queued_at = _ms->getMillis();
+            _advert_stats.depth = ++_num_pending_adverts;
+            if (_advert_stats.depth > _advert_stats.max_depth) _advert_stats.max_depth = _advert_stats.depth;
+            return ACTION_MANUAL_HOLD;   // signature is checked in loop(), before it is acted on or forwarded
+          }
+          _advert_stats.n_overflow++;   // queue full (or pool low), so check it now
         }
+      #endif
+        action = processAdvert(pkt);
       }
       break;
     }
@@ -315,14 +346,54 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
   return action;
 }
 
+// NOTE: advert must already be checked for length, self and hasSeen()
+DispatcherAction Mesh::processAdvert(Packet* pkt) {
+  int i = 0;
+  Identity id;
+  memcpy(id.pub_key, &pkt->payload[i], PUB_KEY_SIZE); i += PUB_KEY_SIZE;
+
+  uint32_t timestamp;
+  memcpy(&timestamp, &pkt->payload[i], 4); i += 4;
+  const uint8_t* signature = &pkt->payload[i]; i += SIGNATURE_SIZE;
+
+  uint8_t* app_data = &pkt->payload[i];
+  int app_data_len = pkt->payload_len - i;
+  if (app_data_len > MAX_ADVERT_DATA_SIZE) { app_data_len = MAX_ADVERT_DATA_SIZE; }
+
+  // check that signature is valid
+  bool is_ok;
+  {
+    uint8_t message[PUB_KEY_SIZE + 4 + MAX_ADVERT_DATA_SIZE];
+    int msg_len = 0;
+    memcpy(&message[msg_len], id.pub_key, PUB_KEY_SIZE); msg_len += PUB_KEY_SIZE;
+    memcpy(&message[msg_len], &timestamp, 4); msg_len += 4;
+    memcpy(&message[msg_len], app_data, app_data_len); msg_len += app_data_len;
+
+    unsigned long t_start = _ms->getMicros();
+    is_ok = id.verify(signature, message, msg_len);
+    uint32_t t = _ms->getMicros() - t_start;
+  #if MESH_LATENCY_STATS
+    _latency.crypto_micros += t;
+  #endif
+    _advert_stats.total_verify_micros += t;
+    if (t > _advert_stats.max_verify_micros) _advert_stats.max_verify_micros = t;
+  }
+  if (is_ok) {
+    MESH_DEBUG_PRINTLN("%s Mesh::onRecvPacket(): valid advertisement received!", getLogDateTime());
+    _advert_stats.n_verified++;
+    onAdvertRecv(pkt, id, timestamp, app_data, app_data_len);
+    return routeRecvPacket(pkt);
+  }
+  MESH_DEBUG_PRINTLN("%s Mesh::onRecvPacket(): received advertisement with forged signature! (app_data_len=%d)", getLogDateTime(), app_data_len);
+  _advert_stats.n_forged++;
+  return ACTION_RELEASE;
+}
+
 void Mesh::removeSelfFromPath(Packet* pkt) {
   // remove our hash from 'path'
   pkt->setPathHashCount(pkt->getPathHashCount() - 1);  // decrement the count
 
-  uint8_t sz = pkt->getPathHashSize();
-  for (int k = 0; k < pkt->getPathHashCount()*sz; k += sz) {  // shuffle path by 1 'entry'
-    memcpy(&pkt->path[k], &pkt->path[k + sz], sz);
-  }
+  memmove(pkt->path, &pkt->path[pkt->getPathHashSize()], pkt->getPathByteLen());  // shuffle path by 1 'entry'
 }
 
 DispatcherAction Mesh::routeRecvPacket(Packet* packet) {
@@ -463,7 +534,7 @@ Packet* Mesh::createPathReturn(const uint8_t* dest_hash, const uint8_t* secret,
       getRNG()->random(&data[data_len], 4); data_len += 4;
     }
 
-    len += Utils::encryptThenMAC(secret, &packet->payload[len], data, data_len);
+    len += Utils::encryptThenMAC(getCryptoContext(secret), &packet->payload[len], data, data_len);
   }
 
   packet->payload_len = len;
@@ -488,7 +559,7 @@ Packet* Mesh::createDatagram(uint8_t type, const Identity& dest, const uint8_t*
   int len = 0;
   len += dest.copyHashTo(&packet->payload[len]);  // dest hash
   len += self_id.copyHashTo(&packet->payload[len]);  // src hash
-  len += Utils::encryptThenMAC(secret, &packet->payload[len], data, data_len);
+  len += Utils::encryptThenMAC(getCryptoContext(secret), &packet->payload[len], data, data_len);
 
   packet->payload_len = len;
 
@@ -516,7 +587,7 @@ Packet* Mesh::createAnonDatagram(uint8_t type, const LocalIdentity& sender, cons
   } else {
     // FUTURE:
   }
-  len += Utils::encryptThenMAC(secret, &packet->payload[len], data, data_len);
+  len += Utils::encryptThenMAC(getCryptoContext(secret), &packet->payload[len], data, data_len);
 
   packet->payload_len = len;
 
@@ -536,7 +607,7 @@ Packet* Mesh::createGroupDatagram(uint8_t type, const GroupChannel& channel, con
 
   int len = 0;
   memcpy(&packet->payload[len], channel.hash, PATH_HASH_SIZE); len += PATH_HASH_SIZE;
-  len += Utils::encryptThenMAC(channel.secret, &packet->payload[len], data, data_len);
+  len += Utils::encryptThenMAC(getChannelCryptoContext(channel), &packet->payload[len], data, data_len);
 
   packet->payload_len = len;
 
@@ -19,6 +19,25 @@ public:
   virtual void clear(const Packet* packet) = 0;   // remove this packet hash from table
 };
 
+#ifndef MESH_ADVERT_VERIFY_QUEUE
+  #define MESH_ADVERT_VERIFY_QUEUE   4    // max adverts held for signature check in loop(), 0 = check in onRecvPacket()
+#endif
+#ifndef MESH_ADVERT_VERIFY_RESERVE
+  #define MESH_ADVERT_VERIFY_RESERVE 3    // free Packets to leave (receive, send, reply), otherwise advert is checked straight away
+#endif
+
+/**
+ * \brief  Telemetry for the advert signature checks (see MESH_ADVERT_VERIFY_QUEUE)
+*/
+struct AdvertVerifyStats {
+  uint16_t depth, max_depth;        // adverts waiting, and high-water mark
+  uint32_t n_verified, n_forged;
+  uint32_t n_deferred;              // checked in loop()
+  uint32_t n_overflow;              // checked straight away, as queue was full (or Packet pool nearly empty)
+  uint32_t total_wait_millis, max_wait_millis;       // of the deferred ones, from receive until checked
+  uint32_t total_verify_micros, max_verify_micros;   // Identity::verify() itself
+};
+
 /**
  * \brief  The next layer in the basic Dispatcher task, Mesh recognises the particular Payload TYPES,
  *     and provides virtual methods for sub-classes on handling incoming, and also preparing outbound Packets.
@@ -27,16 +46,31 @@ class Mesh : public Dispatcher {
   RTCClock* _rtc;
   RNG* _rng;
   MeshTables* _tables;
+#if MESH_ADVERT_VERIFY_QUEUE > 0
+  struct PendingAdvert {
+    Packet* pkt;
+    unsigned long queued_at;
+  };
+  PendingAdvert _pending_adverts[MESH_ADVERT_VERIFY_QUEUE];   // oldest first
+  int _num_pending_adverts;
+#endif
+  AdvertVerifyStats _advert_stats;
+  SharedSecretCache _secrets;
+  CryptoContextCache _crypto;
 
   void removeSelfFromPath(Packet* packet);
+  DispatcherAction processAdvert(Packet* pkt);
+  void checkPendingAdverts();
   void routeDirectRecvAcks(Packet* packet, uint32_t delay_millis);
   //void routeRecvAcks(Packet* packet, uint32_t delay_millis);
   DispatcherAction forwardMultipartDirect(Packet* pkt);
 
 protected:
+  bool _verify_adverts_now;   // when set, onRecvPacket() never holds an advert for loop() to check (eg. imported ones)
+
   DispatcherAction onRecvPacket(Packet* pkt) override;
 
-  virtual uint32_t getCADFailRetryDelay() const override;
+  virtual uint32_t nextRandomInt(uint32_t _max) const override;
 
   /**
    * \brief  Decide what to do with received packet, ie. discard, forward, or hold
@@ -151,6 +185,12 @@ protected:
    */
   virtual int searchChannelsByHash(const uint8_t* hash, GroupChannel channels[], int max_matches);
 
+  /**
+   * \returns  the expanded keys for 'channel'. Default is from the same cache as peer secrets.
+   *          NOTE: only valid until next call
+  */
+  virtual CryptoContext& getChannelCryptoContext(const GroupChannel& channel) { return getCryptoContext(channel.secret); }
+
   /**
    * \brief  An encrypted group data packet has been received.
    *         NOTE: the same payload can be received multiple times, via different routes
@@ -168,6 +208,11 @@ protected:
   Mesh(Radio& radio, MillisecondClock& ms, RNG& rng, RTCClock& rtc, PacketManager& mgr, MeshTables& tables)
     : Dispatcher(radio, ms, mgr), _rng(&rng), _rtc(&rtc), _tables(&tables)
   {
+  #if MESH_ADVERT_VERIFY_QUEUE > 0
+    _num_pending_adverts = 0;
+  #endif
+    memset(&_advert_stats, 0, sizeof(_advert_stats));
+    _verify_adverts_now = false;
   }
 
   MeshTables* getTables() const { return _tables; }
@@ -175,9 +220,28 @@ protected:
 public:
   void begin();
   void loop();
+  uint32_t getMillisToNextEvent(uint32_t max_millis) const override;
+
+  const AdvertVerifyStats& getAdvertVerifyStats() const { return _advert_stats; }
+  void resetAdvertVerifyStats() {
+    uint16_t depth = _advert_stats.depth;
+    memset(&_advert_stats, 0, sizeof(_advert_stats));
+    _advert_stats.depth = _advert_stats.max_depth = depth;
+  }
 
   LocalIdentity self_id;
 
+  /**
+   * \brief  self_id.calcSharedSecret(), via a cache of recently seen peers
+  */
+  void calcSharedSecret(uint8_t* secret, const Identity& other) { _secrets.calcSharedSecret(secret, self_id, other); }
+  SharedSecretCache* getSharedSecretCache() { return &_secrets; }
+
+  /**
+   * \returns  the expanded keys for 'secret', from a cache of recently used ones. NOTE: only valid until next call
+  */
+  CryptoContext& getCryptoContext(const uint8_t* secret) { return _crypto.get(secret); }
+
   RNG* getRNG() const { return _rng; }
   RTCClock* getRTCClock() const { return _rtc; }
 
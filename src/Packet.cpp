@@ -1,13 +1,19 @@
 #include "Packet.h"
 #include <string.h>
 #include <SHA256.h>
+#include "Utils.h"
 
 namespace mesh {
 
+#if MESH_FAST_DEDUPE_HASH
+static uint8_t dedupe_key[16];
+#endif
+
 Packet::Packet() {
   header = 0;
   path_len = 0;
   payload_len = 0;
+  invalidateHash();
 }
 
 bool Packet::isValidPathLen(uint8_t path_len) {
@@ -38,15 +44,62 @@ int Packet::getRawLength() const {
   return 2 + getPathByteLen() + payload_len + (hasTransportCodes() ? 4 : 0);
 }
 
-void Packet::calculatePacketHash(uint8_t* hash) const {
-  SHA256 sha;
+uint32_t Packet::getHashTag() const {
+  // the hash inputs, apart from the payload bytes. Top bit set, so is never 0
   uint8_t t = getPayloadType();
-  sha.update(&t, 1);
-  if (t == PAYLOAD_TYPE_TRACE) {
-    sha.update(&path_len, sizeof(path_len));   // CAVEAT: TRACE packets can revisit same node on return path
+  return 0x80000000 | ((uint32_t)t << 24) | ((t == PAYLOAD_TYPE_TRACE ? path_len & 0xFF : 0) << 16) | payload_len;
+}
+
+void Packet::calculatePacketHash(uint8_t* hash) const {
+  uint32_t tag = getHashTag();
+  if (_hash_tag != tag) {
+    SHA256 sha;
+    uint8_t t = getPayloadType();
+    sha.update(&t, 1);
+    if (t == PAYLOAD_TYPE_TRACE) {
+      sha.update(&path_len, sizeof(path_len));   // CAVEAT: TRACE packets can revisit same node on return path
+    }
+    sha.update(payload, payload_len);
+    sha.finalize(_hash, MAX_HASH_SIZE);
+    _hash_tag = tag;
+  }
+  memcpy(hash, _hash, MAX_HASH_SIZE);
+}
+
+void Packet::setDedupeHashKey(const uint8_t* key) {
+#if MESH_FAST_DEDUPE_HASH
+  memcpy(dedupe_key, key, sizeof(dedupe_key));
+#endif
+}
+
+void Packet::getDedupeHashKey(uint8_t* dest) {
+#if MESH_FAST_DEDUPE_HASH
+  memcpy(dest, dedupe_key, sizeof(dedupe_key));
+#else
+  memset(dest, 0, 16);
+#endif
+}
+
+void Packet::calculateDedupeHash(uint8_t* hash) const {
+#if MESH_FAST_DEDUPE_HASH
+  uint32_t tag = getHashTag();
+  if (_dedupe_tag != tag) {
+    uint8_t msg[1 + sizeof(path_len) + MAX_PACKET_PAYLOAD];   // same inputs as calculatePacketHash()
+    int i = 0;
+    msg[i++] = getPayloadType();
+    if (getPayloadType() == PAYLOAD_TYPE_TRACE) {
+      memcpy(&msg[i], &path_len, sizeof(path_len)); i += sizeof(path_len);
+    }
+    memcpy(&msg[i], payload, payload_len); i += payload_len;
+
+    uint64_t h = Utils::sipHash(dedupe_key, msg, i);
+    memcpy(_dedupe_hash, &h, MAX_HASH_SIZE);
+    _dedupe_tag = tag;
   }
-  sha.update(payload, payload_len);
-  sha.finalize(hash, MAX_HASH_SIZE);
+  memcpy(hash, _dedupe_hash, MAX_HASH_SIZE);
+#else
+  calculatePacketHash(hash);
+#endif
 }
 
 uint8_t Packet::writeTo(uint8_t dest[]) const {
@@ -63,6 +116,7 @@ uint8_t Packet::writeTo(uint8_t dest[]) const {
 }
 
 bool Packet::readFrom(const uint8_t src[], uint8_t len) {
+  invalidateHash();
   uint8_t i = 0;
   header = src[i++];
   if (hasTransportCodes()) {
@@ -49,13 +49,45 @@ public:
   uint8_t path[MAX_PATH_SIZE];
   uint8_t payload[MAX_PACKET_PAYLOAD];
   int8_t _snr;
+#if MESH_LATENCY_STATS
+  uint32_t _lat_stamp;   // millis, when queued (inbound) or due (outbound)
+#endif
+  mutable uint8_t _hash[MAX_HASH_SIZE];   // cached result of calculatePacketHash()
+  mutable uint32_t _hash_tag;             // getHashTag() when _hash was calculated, 0 = none
+#if MESH_FAST_DEDUPE_HASH
+  mutable uint8_t _dedupe_hash[MAX_HASH_SIZE];
+  mutable uint32_t _dedupe_tag;
+#endif
 
   /**
-   * \brief calculate the hash of payload + type
+   * \brief calculate the hash of payload + type. This is cached, so is only calculated once per packet.
+   *        NOTE: changes to type or lengths are detected, but invalidateHash() MUST be called after
+   *        modifying payload[] bytes in place.
    * \param  dest_hash   destination to store the hash (must be MAX_HASH_SIZE bytes)
    */
   void calculatePacketHash(uint8_t* dest_hash) const;
 
+  /**
+   * \brief  a hash for local duplicate detection only (eg. MeshTables), never to be sent or shared.
+   *        With MESH_FAST_DEDUPE_HASH this is a keyed SipHash (see setDedupeHashKey()), otherwise same
+   *        as calculatePacketHash(). Also cached.
+   * \param  dest_hash   destination to store the hash (must be MAX_HASH_SIZE bytes)
+   */
+  void calculateDedupeHash(uint8_t* dest_hash) const;
+
+  /**
+   * \brief  sets the (secret) 16 byte key for calculateDedupeHash(), eg. random per boot.
+   */
+  static void setDedupeHashKey(const uint8_t* key);
+  static void getDedupeHashKey(uint8_t* dest);   // eg. so it can be kept across reboots, with the MeshTables
+
+  void invalidateHash() {
+    _hash_tag = 0;
+  #if MESH_FAST_DEDUPE_HASH
+    _dedupe_tag = 0;
+  #endif
+  }
+
   /**
    * \returns  one of ROUTE_ values
    */
@@ -109,6 +141,9 @@ public:
    * \param  len  the packet length (as returned by writeTo())
    */
   bool readFrom(const uint8_t src[], uint8_t len);
+
+private:
+  uint32_t getHashTag() const;
 };
 
 }
@@ -27,12 +27,82 @@ void Utils::sha256(uint8_t *hash, size_t hash_len, const uint8_t* frag1, int fra
   sha.finalize(hash, hash_len);
 }
 
-int Utils::decrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
-  AES128 aes;
+#define SIP_ROTL(x, b)  (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIP_ROUND  { v0 += v1; v1 = SIP_ROTL(v1, 13); v1 ^= v0; v0 = SIP_ROTL(v0, 32); \
+                     v2 += v3; v3 = SIP_ROTL(v3, 16); v3 ^= v2; \
+                     v0 += v3; v3 = SIP_ROTL(v3, 21); v3 ^= v0; \
+                     v2 += v1; v1 = SIP_ROTL(v1, 17); v1 ^= v2; v2 = SIP_ROTL(v2, 32); }
+
+static uint64_t readLE64(const uint8_t* p, int len) {
+  uint64_t v = 0;
+  for (int i = len - 1; i >= 0; i--) v = (v << 8) | p[i];
+  return v;
+}
+
+uint64_t Utils::sipHash(const uint8_t* key, const uint8_t* msg, int msg_len) {
+  uint64_t k0 = readLE64(key, 8), k1 = readLE64(&key[8], 8);
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+  int n = msg_len & ~7;
+  for (int i = 0; i < n; i += 8) {
+    uint64_t m = readLE64(&msg[i], 8);
+    v3 ^= m;
+    SIP_ROUND; SIP_ROUND;
+    v0 ^= m;
+  }
+  uint64_t b = ((uint64_t)msg_len << 56) | readLE64(&msg[n], msg_len - n);   // last 0..7 bytes + length
+  v3 ^= b;
+  SIP_ROUND; SIP_ROUND;
+  v0 ^= b;
+
+  v2 ^= 0xFF;
+  SIP_ROUND; SIP_ROUND; SIP_ROUND; SIP_ROUND;
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// 2^(i/32) and log2(1 + i/32), in 16.16. Values in between are linearly interpolated
+static const uint32_t exp2_table[33] = {
+  65536, 66971, 68438, 69936, 71468, 73032, 74632, 76266, 77936, 79642, 81386, 83169, 84990, 86851, 88752, 90696,
+  92682, 94711, 96785, 98905, 101070, 103283, 105545, 107856, 110218, 112631, 115098, 117618, 120194, 122825, 125515, 128263,
+  131072
+};
+static const uint32_t log2_table[33] = {
+  0, 2909, 5732, 8473, 11136, 13727, 16248, 18704, 21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346,
+  38336, 40286, 42196, 44068, 45904, 47705, 49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047,
+  65536
+};
+
+static uint32_t interpolate(const uint32_t* table, uint32_t frac) {   // frac is 0..0xFFFF
+  uint32_t i = frac >> 11, r = frac & 0x7FF;
+  return table[i] + (((table[i + 1] - table[i]) * r) >> 11);
+}
+
+uint32_t Utils::exp2Q16(int32_t x) {
+  int32_t i = x >> 16;    // floor
+  if (i >= 16) return 0xFFFFFFFF;
+  if (i < -17) return 0;
+
+  uint32_t m = interpolate(exp2_table, x & 0xFFFF);   // 1.0 .. 2.0
+  return i >= 0 ? m << i : m >> -i;
+}
+
+int32_t Utils::log2Q16(uint32_t x) {
+  if (x == 0) return INT32_MIN;
+
+  int msb = 31;
+  while (!(x & (1UL << msb))) msb--;
+
+  uint32_t m = msb >= 16 ? x >> (msb - 16) : x << (16 - msb);   // normalise to 1.0 .. 2.0
+  return ((msb - 16) * 65536) + interpolate(log2_table, m - 65536);
+}
+
+static int decryptBlocks(AES128& aes, uint8_t* dest, const uint8_t* src, int src_len) {
   uint8_t* dp = dest;
   const uint8_t* sp = src;
 
-  aes.setKey(shared_secret, CIPHER_KEY_SIZE);
   while (sp - src < src_len) {
     aes.decryptBlock(dp, sp);
     dp += 16; sp += 16;
@@ -41,11 +111,9 @@ int Utils::decrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* s
   return sp - src;  // will always be multiple of 16
 }
 
-int Utils::encrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
-  AES128 aes;
+static int encryptBlocks(AES128& aes, uint8_t* dest, const uint8_t* src, int src_len) {
   uint8_t* dp = dest;
 
-  aes.setKey(shared_secret, CIPHER_KEY_SIZE);
   while (src_len >= 16) {
     aes.encryptBlock(dp, src);
     dp += 16; src += 16; src_len -= 16;
@@ -60,6 +128,18 @@ int Utils::encrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* s
   return dp - dest;  // will always be multiple of 16
 }
 
+int Utils::decrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
+  AES128 aes;
+  aes.setKey(shared_secret, CIPHER_KEY_SIZE);
+  return decryptBlocks(aes, dest, src, src_len);
+}
+
+int Utils::encrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
+  AES128 aes;
+  aes.setKey(shared_secret, CIPHER_KEY_SIZE);
+  return encryptBlocks(aes, dest, src, src_len);
+}
+
 int Utils::encryptThenMAC(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
   int enc_len = encrypt(shared_secret, dest + CIPHER_MAC_SIZE, src, src_len);
 
@@ -87,6 +167,102 @@ int Utils::MACThenDecrypt(const uint8_t* shared_secret, uint8_t* dest, const uin
   return 0; // invalid HMAC
 }
 
+#define HMAC_BLOCK_SIZE   64   // of SHA256
+
+void CryptoContext::setSecret(const uint8_t* shared_secret) {
+  // same as SHA256::resetHMAC(), for the inner and outer hashes, ie. key (zero padded to block size) XOR pad
+  uint8_t block[HMAC_BLOCK_SIZE];
+  for (int i = 0; i < HMAC_BLOCK_SIZE; i++) block[i] = (i < PUB_KEY_SIZE ? shared_secret[i] : 0) ^ 0x36;
+  _inner.reset();
+  _inner.update(block, HMAC_BLOCK_SIZE);
+  for (int i = 0; i < HMAC_BLOCK_SIZE; i++) block[i] = (i < PUB_KEY_SIZE ? shared_secret[i] : 0) ^ 0x5C;
+  _outer.reset();
+  _outer.update(block, HMAC_BLOCK_SIZE);
+  memset(block, 0, sizeof(block));
+
+  memcpy(_secret, shared_secret, PUB_KEY_SIZE);
+  _aes_ready = false;
+  _valid = true;
+}
+
+AES128& CryptoContext::getAES() {
+  if (!_aes_ready) {
+    _aes.setKey(_secret, CIPHER_KEY_SIZE);
+    _aes_ready = true;
+  }
+  return _aes;
+}
+
+void CryptoContext::clear() {
+  _aes.clear();
+  _inner.clear();
+  _outer.clear();
+  memset(_secret, 0, sizeof(_secret));
+  _valid = _aes_ready = false;
+}
+
+CryptoContextCache::CryptoContextCache(int size) {
+  _size = size;
+  _contexts = new CryptoContext[size];
+  _last_used = new uint32_t[size];
+  memset(_last_used, 0, sizeof(uint32_t) * size);
+  _use_counter = 0;
+}
+
+CryptoContext& CryptoContextCache::get(const uint8_t* shared_secret) {
+  int lru = 0;
+  for (int i = 0; i < _size; i++) {
+    if (_contexts[i].isFor(shared_secret)) {
+      _last_used[i] = ++_use_counter;
+      return _contexts[i];
+    }
+    if ((int32_t)(_last_used[i] - _last_used[lru]) < 0) lru = i;
+  }
+  _contexts[lru].setSecret(shared_secret);   // NOTE: contexts are re-keyed in place, never moved
+  _last_used[lru] = ++_use_counter;
+  return _contexts[lru];
+}
+
+void CryptoContextCache::clear() {
+  for (int i = 0; i < _size; i++) _contexts[i].clear();
+}
+
+void Utils::calcHMAC(CryptoContext& ctx, uint8_t* mac, const uint8_t* src, int src_len) {
+  uint8_t inner_hash[32];
+  SHA256 sha = ctx._inner;
+  sha.update(src, src_len);
+  sha.finalize(inner_hash, sizeof(inner_hash));
+
+  sha = ctx._outer;
+  sha.update(inner_hash, sizeof(inner_hash));
+  sha.finalize(mac, CIPHER_MAC_SIZE);
+}
+
+int Utils::decrypt(CryptoContext& ctx, uint8_t* dest, const uint8_t* src, int src_len) {
+  return decryptBlocks(ctx.getAES(), dest, src, src_len);
+}
+
+int Utils::encrypt(CryptoContext& ctx, uint8_t* dest, const uint8_t* src, int src_len) {
+  return encryptBlocks(ctx.getAES(), dest, src, src_len);
+}
+
+int Utils::encryptThenMAC(CryptoContext& ctx, uint8_t* dest, const uint8_t* src, int src_len) {
+  int enc_len = encrypt(ctx, dest + CIPHER_MAC_SIZE, src, src_len);
+  calcHMAC(ctx, dest, dest + CIPHER_MAC_SIZE, enc_len);
+  return CIPHER_MAC_SIZE + enc_len;
+}
+
+int Utils::MACThenDecrypt(CryptoContext& ctx, uint8_t* dest, const uint8_t* src, int src_len) {
+  if (src_len <= CIPHER_MAC_SIZE) return 0;  // invalid src bytes
+
+  uint8_t hmac[CIPHER_MAC_SIZE];
+  calcHMAC(ctx, hmac, src + CIPHER_MAC_SIZE, src_len - CIPHER_MAC_SIZE);
+  if (memcmp(hmac, src, CIPHER_MAC_SIZE) == 0) {
+    return decrypt(ctx, dest, src + CIPHER_MAC_SIZE, src_len - CIPHER_MAC_SIZE);
+  }
+  return 0; // invalid HMAC
+}
+
 static const char hex_chars[] = "0123456789ABCDEF";
 
 void Utils::toHex(char* dest, const uint8_t* src, size_t len) {
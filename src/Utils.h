@@ -3,6 +3,8 @@
 #include <MeshCore.h>
 #include <Stream.h>
 #include <string.h>
+#include <AES.h>
+#include <SHA256.h>
 
 namespace mesh {
 
@@ -16,7 +18,60 @@ public:
   uint32_t nextInt(uint32_t _min, uint32_t _max);
 };
 
+/**
+ * \brief  The expanded keys for one shared secret, ie. the AES128 round keys, and the HMAC-SHA256 states after
+ *        the inner and outer key blocks. Saves the key setup in Utils::encryptThenMAC()/MACThenDecrypt() when
+ *        the same secret is used again. Output is identical to the versions taking a raw 'shared_secret'.
+ *        NOTE: can't be copied (AES128 points into itself), so keep instances in place, eg. in a CryptoContextCache
+*/
+class CryptoContext {
+  AES128 _aes;
+  SHA256 _inner, _outer;
+  uint8_t _secret[PUB_KEY_SIZE];
+  bool _valid;
+  bool _aes_ready;    // round keys are expanded on first use, as most trial decrypts fail the MAC check
+
+  CryptoContext(const CryptoContext&) = delete;
+  CryptoContext& operator=(const CryptoContext&) = delete;
+
+  friend class Utils;
+  AES128& getAES();
+
+public:
+  CryptoContext() { _valid = _aes_ready = false; }
+
+  void setSecret(const uint8_t* shared_secret);
+  bool isFor(const uint8_t* shared_secret) const { return _valid && memcmp(_secret, shared_secret, PUB_KEY_SIZE) == 0; }
+  void clear();
+};
+
+#ifndef CRYPTO_CONTEXT_CACHE_SIZE
+  #define CRYPTO_CONTEXT_CACHE_SIZE   4
+#endif
+
+/**
+ * \brief  CryptoContexts for the most recently used shared secrets (eg. the contacts/clients currently messaging)
+*/
+class CryptoContextCache {
+  CryptoContext* _contexts;
+  uint32_t* _last_used;
+  int _size;
+  uint32_t _use_counter;
+
+public:
+  CryptoContextCache(int size=CRYPTO_CONTEXT_CACHE_SIZE);
+
+  /**
+   * \returns  the context for 'shared_secret', re-keying the least recently used one if not found.
+   *          NOTE: only valid until the next call
+  */
+  CryptoContext& get(const uint8_t* shared_secret);
+  void clear();
+};
+
 class Utils {
+  static void calcHMAC(CryptoContext& ctx, uint8_t* mac, const uint8_t* src, int src_len);
+
 public:
   /**
    * \brief  calculates the SHA256 hash of 'msg', storing in 'hash' and truncating the hash to 'hash_len' bytes.
@@ -28,6 +83,22 @@ public:
   */
   static void sha256(uint8_t *hash, size_t hash_len, const uint8_t* frag1, int frag1_len, const uint8_t* frag2, int frag2_len);
 
+  /**
+   * \brief  SipHash-2-4 of 'msg', with 16 byte 'key'. A fast keyed 64-bit hash, for local use only (eg. hash tables).
+  */
+  static uint64_t sipHash(const uint8_t* key, const uint8_t* msg, int msg_len);
+
+  /**
+   * \brief  2^x, in 16.16 fixed point (saturates). Table driven, for MCUs without an FPU, where pow() is very slow.
+   *         Relative error is under 0.02%.
+  */
+  static uint32_t exp2Q16(int32_t x);
+
+  /**
+   * \brief  log2(x), in 16.16 fixed point (x must be > 0). Absolute error is under 0.0002.
+  */
+  static int32_t log2Q16(uint32_t x);
+
   /**
    * \brief  Encrypts the 'src' bytes using AES128 cipher, using 'shared_secret' as key, with key length fixed at CIPHER_KEY_SIZE.
    *         Final block is padded with zero bytes before encrypt. Result stored in 'dest'.
@@ -54,6 +125,14 @@ public:
   */
   static int MACThenDecrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len);
 
+  /**
+   * \brief  same as above, but with pre-expanded keys
+  */
+  static int encrypt(CryptoContext& ctx, uint8_t* dest, const uint8_t* src, int src_len);
+  static int decrypt(CryptoContext& ctx, uint8_t* dest, const uint8_t* src, int src_len);
+  static int encryptThenMAC(CryptoContext& ctx, uint8_t* dest, const uint8_t* src, int src_len);
+  static int MACThenDecrypt(CryptoContext& ctx, uint8_t* dest, const uint8_t* src, int src_len);
+
   /**
    * \brief  converts 'src' bytes with given length to Hex representation, and null terminates.
   */
@@ -22,6 +22,7 @@ public:
 class ArduinoMillis : public mesh::MillisecondClock {
 public:
   unsigned long getMillis() override { return millis(); }
+  unsigned long getMicros() override { return micros(); }
 };
 
 class StdRNG : public mesh::RNG {
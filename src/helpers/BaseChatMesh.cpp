@@ -1,5 +1,8 @@
 #include <helpers/BaseChatMesh.h>
 #include <Utils.h>
+#if CONTACTS_IN_PSRAM
+  #include <new>
+#endif
 
 #ifndef SERVER_RESPONSE_DELAY
   #define SERVER_RESPONSE_DELAY   300
@@ -67,22 +70,110 @@ void BaseChatMesh::bootstrapRTCfromContacts() {
   }
 }
 
+void BaseChatMesh::allocContacts() {
+#if CONTACTS_IN_PSRAM
+  contacts = (ContactInfo *) ps_calloc(MAX_CONTACTS, sizeof(ContactInfo));
+  if (contacts) {
+    for (int i = 0; i < MAX_CONTACTS; i++) new (&contacts[i]) ContactInfo();
+  } else {
+    contacts = new ContactInfo[MAX_CONTACTS];   // no PSRAM fitted, fallback to internal heap
+  }
+#else
+  contacts = contact_store;
+#endif
+}
+
+int BaseChatMesh::compareKey(const ContactKeyRef& ref, const uint8_t* key, int key_len) const {
+  int n = 0;
+#if CONTACT_KEY_PREFIX_SIZE > 0
+  n = key_len < CONTACT_KEY_PREFIX_SIZE ? key_len : CONTACT_KEY_PREFIX_SIZE;
+  int c = memcmp(ref.prefix, key, n);
+  if (c != 0 || n == key_len) return c;   // decided by the index alone
+#endif
+  return memcmp(&contacts[ref.idx].id.pub_key[n], &key[n], key_len - n);
+}
+
+int BaseChatMesh::findKeyOrderPos(const uint8_t* key, int key_len) const {
+  int lo = 0, hi = num_keyed;
+  while (lo < hi) {   // binary search for first entry whose key prefix is >= key
+    int mid = (lo + hi) / 2;
+    if (compareKey(key_order[mid], key, key_len) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+void BaseChatMesh::addToKeyOrder(int idx) {
+  int pos = findKeyOrderPos(contacts[idx].id.pub_key, PUB_KEY_SIZE);
+  memmove(&key_order[pos + 1], &key_order[pos], (num_keyed - pos) * sizeof(key_order[0]));
+#if CONTACT_KEY_PREFIX_SIZE > 0
+  memcpy(key_order[pos].prefix, contacts[idx].id.pub_key, CONTACT_KEY_PREFIX_SIZE);
+#endif
+  key_order[pos].idx = idx;
+  num_keyed++;
+}
+
+void BaseChatMesh::removeFromKeyOrder(int idx) {
+  int pos = findKeyOrderPos(contacts[idx].id.pub_key, PUB_KEY_SIZE);
+  while (pos < num_keyed && key_order[pos].idx != idx) pos++;   // skip any duplicate keys
+  if (pos >= num_keyed) return;   // not indexed
+
+  num_keyed--;
+  memmove(&key_order[pos], &key_order[pos + 1], (num_keyed - pos) * sizeof(key_order[0]));
+}
+
+#define RECENT_NONE   0xFFFF
+
+void BaseChatMesh::linkRecent(int idx) {
+  // insert by lastmod, so is usually at (or near) front
+  uint16_t next = recent_head;
+  while (next != RECENT_NONE && contacts[next].lastmod > contacts[idx].lastmod) {
+    next = recent_next[next];
+  }
+  uint16_t prev = next == RECENT_NONE ? recent_tail : recent_prev[next];
+
+  recent_next[idx] = next;
+  recent_prev[idx] = prev;
+  if (prev == RECENT_NONE) { recent_head = idx; } else { recent_next[prev] = idx; }
+  if (next == RECENT_NONE) { recent_tail = idx; } else { recent_prev[next] = idx; }
+}
+
+void BaseChatMesh::unlinkRecent(int idx) {
+  uint16_t prev = recent_prev[idx], next = recent_next[idx];
+  if (prev == RECENT_NONE) { recent_head = next; } else { recent_next[prev] = next; }
+  if (next == RECENT_NONE) { recent_tail = prev; } else { recent_prev[next] = prev; }
+}
+
+void BaseChatMesh::touchContact(ContactInfo& contact, uint32_t lastmod) {
+  contact.lastmod = lastmod;
+  if (&contact >= contacts && &contact < &contacts[num_contacts]) {   // could be a copy, not in contacts[]
+    int idx = &contact - contacts;
+    unlinkRecent(idx);
+    linkRecent(idx);
+  }
+}
+
+void BaseChatMesh::resetContacts() {
+  num_contacts = num_keyed = 0;
+  recent_head = recent_tail = RECENT_NONE;
+}
+
 ContactInfo* BaseChatMesh::allocateContactSlot() {
   if (num_contacts < MAX_CONTACTS) {
     return &contacts[num_contacts++];
   } else if (shouldOverwriteWhenFull()) {
-    // Find oldest non-favourite contact by oldest lastmod timestamp
-    int oldest_idx = -1;
-    uint32_t oldest_lastmod = 0xFFFFFFFF;
-    for (int i = 0; i < num_contacts; i++) {
-      bool is_favourite = (contacts[i].flags & 0x01) != 0;
-      if (!is_favourite && contacts[i].lastmod < oldest_lastmod) {
-        oldest_lastmod = contacts[i].lastmod;
-        oldest_idx = i;
-      }
+    // Find oldest non-favourite contact, from back of the recent list
+    uint16_t oldest_idx = recent_tail;
+    while (oldest_idx != RECENT_NONE && (contacts[oldest_idx].flags & 0x01) != 0) {
+      oldest_idx = recent_prev[oldest_idx];
     }
-    if (oldest_idx >= 0) {
+    if (oldest_idx != RECENT_NONE) {
       onContactOverwrite(contacts[oldest_idx].id.pub_key);
+      removeFromKeyOrder(oldest_idx);  // caller re-indexes it, once new key is in place
+      unlinkRecent(oldest_idx);
       return &contacts[oldest_idx];
     }
   }
@@ -110,16 +201,10 @@ void BaseChatMesh::onAdvertRecv(mesh::Packet* packet, const mesh::Identity& id,
     return;
   }
 
-  ContactInfo* from = NULL;
-  for (int i = 0; i < num_contacts; i++) {
-    if (id.matches(contacts[i].id)) {  // is from one of our contacts
-      from = &contacts[i];
-      if (timestamp <= from->last_advert_timestamp) {  // check for replay attacks!!
-        MESH_DEBUG_PRINTLN("onAdvertRecv: Possible replay attack, name: %s", from->name);
-        return;
-      }
-      break;
-    }
+  ContactInfo* from = lookupContactByPubKey(id.pub_key, PUB_KEY_SIZE);
+  if (from && timestamp <= from->last_advert_timestamp) {  // check for replay attacks!!
+    MESH_DEBUG_PRINTLN("onAdvertRecv: Possible replay attack, name: %s", from->name);
+    return;
   }
 
   // save a copy of raw advert packet (to support "Share..." function)
@@ -163,6 +248,8 @@ void BaseChatMesh::onAdvertRecv(mesh::Packet* packet, const mesh::Identity& id,
     populateContactFromAdvert(*from, id, parser, timestamp);
     from->sync_since = 0;
     from->shared_secret_valid = false;
+    addToKeyOrder(from - contacts);
+    linkRecent(from - contacts);
   }
   // update
     putBlobByKey(id.pub_key, PUB_KEY_SIZE, temp_buf, plen);
@@ -173,17 +260,18 @@ void BaseChatMesh::onAdvertRecv(mesh::Packet* packet, const mesh::Identity& id,
       from->gps_lon = parser.getIntLon();
     }
     from->last_advert_timestamp = timestamp;
-    from->lastmod = getRTCClock()->getCurrentTime();
+    touchContact(*from);
 
   onDiscoveredContact(*from, is_new, packet->path_len, packet->path);       // let UI know
 }
 
 int BaseChatMesh::searchPeersByHash(const uint8_t* hash) {
   int n = 0;
-  for (int i = 0; i < num_contacts && n < MAX_SEARCH_RESULTS; i++) {
-    if (contacts[i].id.isHashMatch(hash)) {
-      matching_peer_indexes[n++] = i;  // store the INDEXES of matching contacts (for subsequent 'peer' methods)
-    }
+  for (int pos = findKeyOrderPos(hash, PATH_HASH_SIZE); pos < num_keyed && n < MAX_SEARCH_RESULTS; pos++) {
+    if (compareKey(key_order[pos], hash, PATH_HASH_SIZE) != 0) break;   // past the run of matching keys
+    int i = key_order[pos].idx;
+
+    matching_peer_indexes[n++] = i;  // store the INDEXES of matching contacts (for subsequent 'peer' methods)
   }
   return n;
 }
@@ -191,7 +279,7 @@ int BaseChatMesh::searchPeersByHash(const uint8_t* hash) {
 void BaseChatMesh::getPeerSharedSecret(uint8_t* dest_secret, int peer_idx) {
   int i = matching_peer_indexes[peer_idx];
   if (i >= 0 && i < num_contacts) {
-    memcpy(dest_secret, contacts[i].getSharedSecret(self_id), PUB_KEY_SIZE);
+    memcpy(dest_secret, contacts[i].getSharedSecret(self_id, getSharedSecretCache()), PUB_KEY_SIZE);
   } else {
     MESH_DEBUG_PRINTLN("getPeerSharedSecret: Invalid peer idx: %d", i);
   }
@@ -215,7 +303,7 @@ void BaseChatMesh::onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender
     data[len] = 0; // need to make a C string again, with null terminator
 
     if (flags == TXT_TYPE_PLAIN) {
-      from.lastmod = getRTCClock()->getCurrentTime(); // update last heard time
+      touchContact(from); // update last heard time
       onMessageRecv(from, packet, timestamp, (const char *) &data[5]);  // let UI know
 
       uint32_t ack_hash;    // calc truncated hash of the message timestamp + text + sender pub_key, to prove to sender that we got it
@@ -242,7 +330,7 @@ void BaseChatMesh::onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender
       if (timestamp > from.sync_since) {  // make sure 'sync_since' is up-to-date
         from.sync_since = timestamp;
       }
-      from.lastmod = getRTCClock()->getCurrentTime(); // update last heard time
+      touchContact(from); // update last heard time
       onSignedMessageRecv(from, packet, timestamp, &data[5], (const char *) &data[9]);  // let UI know
 
       uint32_t ack_hash;    // calc truncated hash of the message timestamp + text + OUR pub_key, to prove to sender that we got it
@@ -305,7 +393,7 @@ bool BaseChatMesh::onContactPathRecv(ContactInfo& from, uint8_t* in_path, uint8_
   // NOTE: default impl, we just replace the current 'out_path' regardless, whenever sender sends us a new out_path.
   // FUTURE: could store multiple out_paths per contact, and try to find which is the 'best'(?)
   from.out_path_len = mesh::Packet::copyPath(from.out_path, out_path, out_path_len);  // store a copy of path, for sendDirect()
-  from.lastmod = getRTCClock()->getCurrentTime();
+  touchContact(from);
 
   onContactPathUpdated(from);
 
@@ -336,18 +424,29 @@ void BaseChatMesh::onAckRecv(mesh::Packet* packet, uint32_t ack_crc) {
 void BaseChatMesh::handleReturnPathRetry(const ContactInfo& contact, const uint8_t* path, uint8_t path_len) {
   // NOTE: simplest impl is just to re-send a reciprocal return path to sender (DIRECTLY)
   //        override this method in various firmwares, if there's a better strategy
-  mesh::Packet* rpath = createPathReturn(contact.id, contact.getSharedSecret(self_id), path, path_len, 0, NULL, 0);
+  mesh::Packet* rpath = createPathReturn(contact.id, contact.getSharedSecret(self_id, getSharedSecretCache()), path, path_len, 0, NULL, 0);
   if (rpath) sendDirect(rpath, contact.out_path, contact.out_path_len, 3000);   // 3 second delay
 }
 
 #ifdef MAX_GROUP_CHANNELS
 int BaseChatMesh::searchChannelsByHash(const uint8_t* hash, mesh::GroupChannel dest[], int max_matches) {
-  int n = 0;
-  for (int i = 0; i < MAX_GROUP_CHANNELS && n < max_matches; i++) {
-    if (channels[i].channel.hash[0] == hash[0]) {
-      dest[n++] = channels[i].channel;
+  int lo = 0, hi = num_ordered_channels;
+  while (lo < hi) {   // binary search for first channel with hash >= 'hash'
+    int mid = (lo + hi) / 2;
+    if (channels[channel_order[mid]].channel.hash[0] < hash[0]) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
     }
   }
+
+  int n = 0;
+  for (int pos = lo; pos < num_ordered_channels && n < max_matches; pos++) {
+    auto ch = &channels[channel_order[pos]].channel;
+    if (ch->hash[0] != hash[0]) break;   // past the run of matching hashes
+
+    dest[n++] = *ch;
+  }
   return n;
 }
 #endif
@@ -412,7 +511,7 @@ mesh::Packet* BaseChatMesh::composeMsgPacket(const ContactInfo& recipient, uint3
     temp[len++] = attempt;  // hide attempt number at tail end of payload
   }
 
-  return createDatagram(PAYLOAD_TYPE_TXT_MSG, recipient.id, recipient.getSharedSecret(self_id), temp, len);
+  return createDatagram(PAYLOAD_TYPE_TXT_MSG, recipient.id, recipient.getSharedSecret(self_id, getSharedSecretCache()), temp, len);
 }
 
 int  BaseChatMesh::sendMessage(const ContactInfo& recipient, uint32_t timestamp, uint8_t attempt, const char* text, uint32_t& expected_ack, uint32_t& est_timeout) {
@@ -443,7 +542,7 @@ int  BaseChatMesh::sendCommandData(const ContactInfo& recipient, uint32_t timest
   temp[4] = (attempt & 3) | (TXT_TYPE_CLI_DATA << 2);
   memcpy(&temp[5], text, text_len + 1);
 
-  auto pkt = createDatagram(PAYLOAD_TYPE_TXT_MSG, recipient.id, recipient.getSharedSecret(self_id), temp, 5 + text_len);
+  auto pkt = createDatagram(PAYLOAD_TYPE_TXT_MSG, recipient.id, recipient.getSharedSecret(self_id, getSharedSecretCache()), temp, 5 + text_len);
   if (pkt == NULL) return MSG_SEND_FAILED;
 
   uint32_t t = _radio->getEstAirtimeFor(pkt->getRawLength());
@@ -563,7 +662,7 @@ int BaseChatMesh::sendLogin(const ContactInfo& recipient, const char* password,
       tlen = 4 + len;
     }
 
-    pkt = createAnonDatagram(PAYLOAD_TYPE_ANON_REQ, self_id, recipient.id, recipient.getSharedSecret(self_id), temp, tlen);
+    pkt = createAnonDatagram(PAYLOAD_TYPE_ANON_REQ, self_id, recipient.id, recipient.getSharedSecret(self_id, getSharedSecretCache()), temp, tlen);
   }
   if (pkt) {
     uint32_t t = _radio->getEstAirtimeFor(pkt->getRawLength());
@@ -588,7 +687,7 @@ int BaseChatMesh::sendAnonReq(const ContactInfo& recipient, const uint8_t* data,
     memcpy(temp, &tag, 4);   // tag to match later (also extra blob to help make packet_hash unique)
     memcpy(&temp[4], data, len);
 
-    pkt = createAnonDatagram(PAYLOAD_TYPE_ANON_REQ, self_id, recipient.id, recipient.getSharedSecret(self_id), temp, 4 + len);
+    pkt = createAnonDatagram(PAYLOAD_TYPE_ANON_REQ, self_id, recipient.id, recipient.getSharedSecret(self_id, getSharedSecretCache()), temp, 4 + len);
   }
   if (pkt) {
     uint32_t t = _radio->getEstAirtimeFor(pkt->getRawLength());
@@ -615,7 +714,7 @@ int  BaseChatMesh::sendRequest(const ContactInfo& recipient, const uint8_t* req_
     memcpy(temp, &tag, 4);   // mostly an extra blob to help make packet_hash unique
     memcpy(&temp[4], req_data, data_len);
 
-    pkt = createDatagram(PAYLOAD_TYPE_REQ, recipient.id, recipient.getSharedSecret(self_id), temp, 4 + data_len);
+    pkt = createDatagram(PAYLOAD_TYPE_REQ, recipient.id, recipient.getSharedSecret(self_id, getSharedSecretCache()), temp, 4 + data_len);
   }
   if (pkt) {
     uint32_t t = _radio->getEstAirtimeFor(pkt->getRawLength());
@@ -642,7 +741,7 @@ int  BaseChatMesh::sendRequest(const ContactInfo& recipient, uint8_t req_type, u
     memset(&temp[5], 0, 4);  // reserved (possibly for 'since' param)
     getRNG()->random(&temp[9], 4);   // random blob to help make packet-hash unique
 
-    pkt = createDatagram(PAYLOAD_TYPE_REQ, recipient.id, recipient.getSharedSecret(self_id), temp, sizeof(temp));
+    pkt = createDatagram(PAYLOAD_TYPE_REQ, recipient.id, recipient.getSharedSecret(self_id, getSharedSecretCache()), temp, sizeof(temp));
   }
   if (pkt) {
     uint32_t t = _radio->getEstAirtimeFor(pkt->getRawLength());
@@ -765,7 +864,7 @@ void BaseChatMesh::checkConnections() {
       // calc expected ACK reply
       mesh::Utils::sha256((uint8_t *)&connections[i].expected_ack, 4, data, 9, self_id.pub_key, PUB_KEY_SIZE);
 
-      auto pkt = createDatagram(PAYLOAD_TYPE_REQ, contact->id, contact->getSharedSecret(self_id), data, 9);
+      auto pkt = createDatagram(PAYLOAD_TYPE_REQ, contact->id, contact->getSharedSecret(self_id, getSharedSecretCache()), data, 9);
       if (pkt) {
         sendDirect(pkt, contact->out_path, contact->out_path_len);
       }
@@ -780,30 +879,12 @@ void BaseChatMesh::resetPathTo(ContactInfo& recipient) {
   recipient.out_path_len = OUT_PATH_UNKNOWN;
 }
 
-static ContactInfo* table;  // pass via global :-(
-
-static int cmp_adv_timestamp(const void *a, const void *b) {
-  int a_idx = *((int *)a);
-  int b_idx = *((int *)b);
-  if (table[b_idx].last_advert_timestamp > table[a_idx].last_advert_timestamp) return 1;
-  if (table[b_idx].last_advert_timestamp < table[a_idx].last_advert_timestamp) return -1;
-  return 0;
-}
-
 void BaseChatMesh::scanRecentContacts(int last_n, ContactVisitor* visitor) {
-  for (int i = 0; i < num_contacts; i++) {  // sort the INDEXES into contacts[]
-    sort_array[i] = i;
-  }
-  table = contacts; // pass via global *sigh* :-(
-  qsort(sort_array, num_contacts, sizeof(sort_array[0]), cmp_adv_timestamp);
-
   if (last_n == 0) {
     last_n = num_contacts;   // scan ALL
-  } else {
-    if (last_n > num_contacts) last_n = num_contacts;
   }
-  for (int i = 0; i < last_n; i++) {
-    visitor->onContactVisit(contacts[sort_array[i]]);
+  for (uint16_t i = recent_head; i != RECENT_NONE && last_n > 0; i = recent_next[i], last_n--) {
+    visitor->onContactVisit(contacts[i]);
   }
 }
 
@@ -817,36 +898,61 @@ ContactInfo* BaseChatMesh::searchContactsByPrefix(const char* name_prefix) {
 }
 
 ContactInfo* BaseChatMesh::lookupContactByPubKey(const uint8_t* pub_key, int prefix_len) {
-  for (int i = 0; i < num_contacts; i++) {
-    auto c = &contacts[i];
-    if (memcmp(c->id.pub_key, pub_key, prefix_len) == 0) return c;
+  int pos = findKeyOrderPos(pub_key, prefix_len);
+  if (pos < num_keyed && compareKey(key_order[pos], pub_key, prefix_len) == 0) {
+    return &contacts[key_order[pos].idx];
   }
   return NULL;  // not found
 }
 
 bool BaseChatMesh::addContact(const ContactInfo& contact) {
-  ContactInfo* dest = allocateContactSlot();
+  ContactInfo* dest = lookupContactByPubKey(contact.id.pub_key, PUB_KEY_SIZE);
+  if (dest) {   // already have it, just replace (eg. replaying a journal of changes)
+    int idx = dest - contacts;
+    unlinkRecent(idx);
+    *dest = contact;
+    dest->shared_secret_valid = false; // mark shared_secret as needing calculation
+    linkRecent(idx);
+    return true;
+  }
+
+  dest = allocateContactSlot();
   if (dest) {
     *dest = contact;
     dest->shared_secret_valid = false; // mark shared_secret as needing calculation
+    addToKeyOrder(dest - contacts);
+    linkRecent(dest - contacts);
     return true;  // success
   }
   return false;
 }
 
 bool BaseChatMesh::removeContact(ContactInfo& contact) {
-  int idx = 0;
-  while (idx < num_contacts && !contacts[idx].id.matches(contact.id)) {
-    idx++;
-  }
-  if (idx >= num_contacts) return false;   // not found
+  ContactInfo* found = lookupContactByPubKey(contact.id.pub_key, PUB_KEY_SIZE);
+  if (found == NULL) return false;   // not found
+
+  int idx = found - contacts;
+  removeFromKeyOrder(idx);
+  unlinkRecent(idx);
 
   // remove from contacts array
   num_contacts--;
-  while (idx < num_contacts) {
-    contacts[idx] = contacts[idx + 1];
-    idx++;
+  for (int i = idx; i < num_contacts; i++) {
+    contacts[i] = contacts[i + 1];
+    recent_next[i] = recent_next[i + 1];
+    recent_prev[i] = recent_prev[i + 1];
+  }
+
+  // contacts after idx have moved down one
+  for (int pos = 0; pos < num_keyed; pos++) {
+    if (key_order[pos].idx > idx) key_order[pos].idx--;
+  }
+  for (int i = 0; i < num_contacts; i++) {
+    if (recent_next[i] != RECENT_NONE && recent_next[i] > idx) recent_next[i]--;
+    if (recent_prev[i] != RECENT_NONE && recent_prev[i] > idx) recent_prev[i]--;
   }
+  if (recent_head != RECENT_NONE && recent_head > idx) recent_head--;
+  if (recent_tail != RECENT_NONE && recent_tail > idx) recent_tail--;
   return true;  // Success
 }
 
@@ -863,6 +969,7 @@ ChannelDetails* BaseChatMesh::addChannel(const char* name, const char* psk_base6
       mesh::Utils::sha256(dest->channel.hash, sizeof(dest->channel.hash), dest->channel.secret, len);
       StrHelper::strncpy(dest->name, name, sizeof(dest->name));
       num_channels++;
+      updateChannelOrder();
       return dest;
     }
   }
@@ -885,6 +992,7 @@ bool BaseChatMesh::setChannel(int idx, const ChannelDetails& src) {
     } else {
       mesh::Utils::sha256(channels[idx].channel.hash, sizeof(channels[idx].channel.hash), src.channel.secret, 32);  // 256-bit key
     }
+    updateChannelOrder();
     return true;
   }
   return false;
@@ -895,6 +1003,21 @@ int BaseChatMesh::findChannelIdx(const mesh::GroupChannel& ch) {
   }
   return -1;  // not found
 }
+void BaseChatMesh::updateChannelOrder() {
+  static uint8_t zeroes[PUB_KEY_SIZE];
+
+  num_ordered_channels = 0;
+  for (int i = 0; i < MAX_GROUP_CHANNELS; i++) {
+    if (memcmp(channels[i].channel.secret, zeroes, sizeof(zeroes)) == 0) continue;   // slot not in use
+
+    int pos = num_ordered_channels++;   // insertion sort, by hash
+    while (pos > 0 && channels[channel_order[pos - 1]].channel.hash[0] > channels[i].channel.hash[0]) {
+      channel_order[pos] = channel_order[pos - 1];
+      pos--;
+    }
+    channel_order[pos] = i;
+  }
+}
 #else
 ChannelDetails* BaseChatMesh::addChannel(const char* name, const char* psk_base64) {
   return NULL;  // not supported
@@ -938,7 +1061,9 @@ void BaseChatMesh::loop() {
   }
 
   if (_pendingLoopback) {
+    _verify_adverts_now = true;   // is released straight after, so mustn't be held
     onRecvPacket(_pendingLoopback);  // loop-back, as if received over radio
+    _verify_adverts_now = false;
     releasePacket(_pendingLoopback);   // undo the obtainNewPacket()
     _pendingLoopback = NULL;
   }
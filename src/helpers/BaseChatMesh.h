@@ -11,6 +11,14 @@
 
 #define MAX_SEARCH_RESULTS   8
 
+#ifndef CHANNEL_CRYPTO_CACHE_SIZE    // expanded keys of the most recently used channels (~450 bytes each)
+  #if defined(ESP32)
+    #define CHANNEL_CRYPTO_CACHE_SIZE   8   // NOTE: not every channel, is allocated up front
+  #else
+    #define CHANNEL_CRYPTO_CACHE_SIZE   4
+  #endif
+#endif
+
 #define MSG_SEND_FAILED       0
 #define MSG_SEND_SENT_FLOOD   1
 #define MSG_SEND_SENT_DIRECT  2
@@ -37,6 +45,28 @@ public:
   #define MAX_CONTACTS  32
 #endif
 
+#ifndef CONTACTS_IN_PSRAM
+  #define CONTACTS_IN_PSRAM   0   // 1 = ContactInfo records in PSRAM, with just the key index in internal RAM
+#endif
+
+#ifndef CONTACT_KEY_PREFIX_SIZE
+  #if CONTACTS_IN_PSRAM
+    #define CONTACT_KEY_PREFIX_SIZE   8   // pub_key bytes copied into the key index, so searches rarely touch PSRAM
+  #else
+    #define CONTACT_KEY_PREFIX_SIZE   0   // contacts[] already in internal RAM
+  #endif
+#endif
+
+/**
+ *  \brief  entry in the key index (the 'hot' part of a contact)
+ */
+struct ContactKeyRef {
+#if CONTACT_KEY_PREFIX_SIZE > 0
+  uint8_t prefix[CONTACT_KEY_PREFIX_SIZE];   // copy of first bytes of pub_key
+#endif
+  uint16_t idx;   // INDEX into contacts[]
+};
+
 #ifndef MAX_CONNECTIONS
   #define MAX_CONNECTIONS  16
 #endif
@@ -58,14 +88,25 @@ class BaseChatMesh : public mesh::Mesh {
 
   friend class ContactsIterator;
 
-  ContactInfo contacts[MAX_CONTACTS];
+  ContactInfo* contacts;   // the 'cold' records, see CONTACTS_IN_PSRAM
+#if !CONTACTS_IN_PSRAM
+  ContactInfo contact_store[MAX_CONTACTS];
+#endif
   int num_contacts;
-  int sort_array[MAX_CONTACTS];
+  ContactKeyRef key_order[MAX_CONTACTS];   // sorted by pub_key (a hash is just a key prefix)
+  int num_keyed;
+  uint16_t recent_next[MAX_CONTACTS], recent_prev[MAX_CONTACTS];   // list of INDEXES into contacts[], most recently heard first
+  uint16_t recent_head, recent_tail;
   int matching_peer_indexes[MAX_SEARCH_RESULTS];
   unsigned long txt_send_timeout;
 #ifdef MAX_GROUP_CHANNELS
   ChannelDetails channels[MAX_GROUP_CHANNELS];
   int num_channels;  // only for addChannel()
+  uint16_t channel_order[MAX_GROUP_CHANNELS];   // INDEXES of channels in use, sorted by hash
+  int num_ordered_channels;
+  mesh::CryptoContextCache channel_crypto;
+
+  void updateChannelOrder();
 #endif
   mesh::Packet* _pendingLoopback;
   uint8_t temp_buf[MAX_TRANS_UNIT];
@@ -73,15 +114,27 @@ class BaseChatMesh : public mesh::Mesh {
 
   mesh::Packet* composeMsgPacket(const ContactInfo& recipient, uint32_t timestamp, uint8_t attempt, const char *text, uint32_t& expected_ack);
   void sendAckTo(const ContactInfo& dest, uint32_t ack_hash);
+  int compareKey(const ContactKeyRef& ref, const uint8_t* key, int key_len) const;
+  int findKeyOrderPos(const uint8_t* key, int key_len) const;
+  void addToKeyOrder(int idx);
+  void removeFromKeyOrder(int idx);
+  void linkRecent(int idx);
+  void unlinkRecent(int idx);
+  void allocContacts();
 
 protected:
   BaseChatMesh(mesh::Radio& radio, mesh::MillisecondClock& ms, mesh::RNG& rng, mesh::RTCClock& rtc, mesh::PacketManager& mgr, mesh::MeshTables& tables)
       : mesh::Mesh(radio, ms, rng, rtc, mgr, tables)
+  #ifdef MAX_GROUP_CHANNELS
+      , channel_crypto(CHANNEL_CRYPTO_CACHE_SIZE)
+  #endif
   { 
-    num_contacts = 0;
+    allocContacts();
+    resetContacts();
   #ifdef MAX_GROUP_CHANNELS
     memset(channels, 0, sizeof(channels));
     num_channels = 0;
+    num_ordered_channels = 0;
   #endif
     txt_send_timeout = 0;
     _pendingLoopback = NULL;
@@ -89,7 +142,9 @@ protected:
   }
 
   void bootstrapRTCfromContacts();
-  void resetContacts() { num_contacts = 0; }
+  void resetContacts();
+  void touchContact(ContactInfo& contact) { touchContact(contact, getRTCClock()->getCurrentTime()); }
+  void touchContact(ContactInfo& contact, uint32_t lastmod);   // sets lastmod, and moves to its place in recent list
   void populateContactFromAdvert(ContactInfo& ci, const mesh::Identity& id, const AdvertDataParser& parser, uint32_t timestamp);
   ContactInfo* allocateContactSlot(); // helper to find slot for new contact
 
@@ -133,6 +188,7 @@ protected:
   void onAckRecv(mesh::Packet* packet, uint32_t ack_crc) override;
 #ifdef MAX_GROUP_CHANNELS
   int searchChannelsByHash(const uint8_t* hash, mesh::GroupChannel channels[], int max_matches) override;
+  mesh::CryptoContext& getChannelCryptoContext(const mesh::GroupChannel& channel) override { return channel_crypto.get(channel.secret); }
 #endif
   void onGroupDataRecv(mesh::Packet* packet, uint8_t type, const mesh::GroupChannel& channel, uint8_t* data, size_t len) override;
 
@@ -159,7 +215,7 @@ public:
   uint8_t exportContact(const ContactInfo& contact, uint8_t dest_buf[]);
   bool importContact(const uint8_t src_buf[], uint8_t len);
   void resetPathTo(ContactInfo& recipient);
-  void scanRecentContacts(int last_n, ContactVisitor* visitor);
+  void scanRecentContacts(int last_n, ContactVisitor* visitor);   // most recently heard first
   ContactInfo* searchContactsByPrefix(const char* name_prefix);
   ContactInfo* lookupContactByPubKey(const uint8_t* pub_key, int prefix_len);
   bool  removeContact(ContactInfo& contact);
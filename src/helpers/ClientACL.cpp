@@ -11,7 +11,15 @@ static File openWrite(FILESYSTEM* _fs, const char* filename) {
   #endif
 }
 
-void ClientACL::load(FILESYSTEM* fs, const mesh::LocalIdentity& self_id) {
+static void calcSharedSecret(uint8_t* secret, const mesh::LocalIdentity& self_id, const uint8_t* pub_key, mesh::SharedSecretCache* secrets) {
+  if (secrets) {
+    secrets->calcSharedSecret(secret, self_id, pub_key);
+  } else {
+    self_id.calcSharedSecret(secret, pub_key);
+  }
+}
+
+void ClientACL::load(FILESYSTEM* fs, const mesh::LocalIdentity& self_id, mesh::SharedSecretCache* secrets) {
   _fs = fs;
   num_clients = 0;
   if (_fs->exists("/s_contacts")) {
@@ -40,7 +48,7 @@ void ClientACL::load(FILESYSTEM* fs, const mesh::LocalIdentity& self_id) {
         if (!success) break; // EOF
 
         c.id = mesh::Identity(pub_key);
-        self_id.calcSharedSecret(c.shared_secret, pub_key);  // recalculate shared secrets in case our private key changed
+        calcSharedSecret(c.shared_secret, self_id, pub_key, secrets);  // recalculate shared secrets in case our private key changed
         if (num_clients < MAX_CLIENTS) {
           clients[num_clients++] = c;
         } else {
@@ -118,7 +126,7 @@ ClientInfo* ClientACL::putClient(const mesh::Identity& id, uint8_t init_perms) {
   return c;
 }
 
-bool ClientACL::applyPermissions(const mesh::LocalIdentity& self_id, const uint8_t* pubkey, int key_len, uint8_t perms) {
+bool ClientACL::applyPermissions(const mesh::LocalIdentity& self_id, const uint8_t* pubkey, int key_len, uint8_t perms, mesh::SharedSecretCache* secrets) {
   ClientInfo* c;
   if ((perms & PERM_ACL_ROLE_MASK) == PERM_ACL_GUEST) {  // guest role is not persisted in contacts
     c = getClient(pubkey, key_len);
@@ -137,7 +145,7 @@ bool ClientACL::applyPermissions(const mesh::LocalIdentity& self_id, const uint8
     c = putClient(id, 0);
 
     c->permissions = perms;  // update their permissions
-    self_id.calcSharedSecret(c->shared_secret, pubkey);
+    calcSharedSecret(c->shared_secret, self_id, pubkey, secrets);
   }
   return true;
 }
@@ -47,13 +47,13 @@ public:
     memset(clients, 0, sizeof(clients));
     num_clients = 0;
   }
-  void load(FILESYSTEM* _fs, const mesh::LocalIdentity& self_id);
+  void load(FILESYSTEM* _fs, const mesh::LocalIdentity& self_id, mesh::SharedSecretCache* secrets=NULL);
   void save(FILESYSTEM* _fs, bool (*filter)(ClientInfo*)=NULL);
   bool clear();
 
   ClientInfo* getClient(const uint8_t* pubkey, int key_len);
   ClientInfo* putClient(const mesh::Identity& id, uint8_t init_perms);
-  bool applyPermissions(const mesh::LocalIdentity& self_id, const uint8_t* pubkey, int key_len, uint8_t perms);
+  bool applyPermissions(const mesh::LocalIdentity& self_id, const uint8_t* pubkey, int key_len, uint8_t perms, mesh::SharedSecretCache* secrets=NULL);
 
   int getNumClients() const { return num_clients; }
   ClientInfo* getClientByIdx(int idx) { return &clients[idx]; }
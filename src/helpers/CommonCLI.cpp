@@ -88,7 +88,12 @@ void CommonCLI::loadPrefsInt(FILESYSTEM* fs, const char* filename) {
     file.read((uint8_t *)&_prefs->adc_multiplier, sizeof(_prefs->adc_multiplier));                 // 166
     file.read((uint8_t *)_prefs->owner_info, sizeof(_prefs->owner_info));                          // 170
     file.read((uint8_t *)&_prefs->rx_boosted_gain, sizeof(_prefs->rx_boosted_gain));              // 290
-    // next: 291
+    file.read((uint8_t *)_prefs->tx_class_weights, sizeof(_prefs->tx_class_weights));              // 291
+    file.read((uint8_t *)&_prefs->flood_suppress, sizeof(_prefs->flood_suppress));                 // 295
+    file.read((uint8_t *)&_prefs->flood_suppress_snr, sizeof(_prefs->flood_suppress_snr));         // 296
+    file.read((uint8_t *)&_prefs->flood_delay_mode, sizeof(_prefs->flood_delay_mode));             // 297
+    file.read((uint8_t *)&_prefs->duty_cycle_bands, sizeof(_prefs->duty_cycle_bands));             // 298
+    // next: 299
 
     // sanitise bad pref values
     _prefs->rx_delay_base = constrain(_prefs->rx_delay_base, 0, 20.0f);
@@ -103,6 +108,10 @@ void CommonCLI::loadPrefsInt(FILESYSTEM* fs, const char* filename) {
     _prefs->multi_acks = constrain(_prefs->multi_acks, 0, 1);
     _prefs->adc_multiplier = constrain(_prefs->adc_multiplier, 0.0f, 10.0f);
     _prefs->path_hash_mode = constrain(_prefs->path_hash_mode, 0, 2);   // NOTE: mode 3 reserved for future
+    _prefs->flood_suppress = constrain(_prefs->flood_suppress, 0, 8);
+    _prefs->flood_suppress_snr = constrain(_prefs->flood_suppress_snr, 0, 1);
+    _prefs->flood_delay_mode = constrain(_prefs->flood_delay_mode, 0, 1);
+    _prefs->duty_cycle_bands = constrain(_prefs->duty_cycle_bands, 0, 1);
 
     // sanitise bad bridge pref values
     _prefs->bridge_enabled = constrain(_prefs->bridge_enabled, 0, 1);
@@ -179,7 +188,12 @@ void CommonCLI::savePrefs(FILESYSTEM* fs) {
     file.write((uint8_t *)&_prefs->adc_multiplier, sizeof(_prefs->adc_multiplier));                 // 166
     file.write((uint8_t *)_prefs->owner_info, sizeof(_prefs->owner_info));                          // 170
     file.write((uint8_t *)&_prefs->rx_boosted_gain, sizeof(_prefs->rx_boosted_gain));              // 290
-    // next: 291
+    file.write((uint8_t *)_prefs->tx_class_weights, sizeof(_prefs->tx_class_weights));              // 291
+    file.write((uint8_t *)&_prefs->flood_suppress, sizeof(_prefs->flood_suppress));                 // 295
+    file.write((uint8_t *)&_prefs->flood_suppress_snr, sizeof(_prefs->flood_suppress_snr));         // 296
+    file.write((uint8_t *)&_prefs->flood_delay_mode, sizeof(_prefs->flood_delay_mode));             // 297
+    file.write((uint8_t *)&_prefs->duty_cycle_bands, sizeof(_prefs->duty_cycle_bands));             // 298
+    // next: 299
 
     file.close();
   }
@@ -209,12 +223,15 @@ uint8_t CommonCLI::buildAdvertData(uint8_t node_type, uint8_t* app_data) {
 
 void CommonCLI::handleCommand(uint32_t sender_timestamp, char* command, char* reply) {
     if (memcmp(command, "poweroff", 8) == 0 || memcmp(command, "shutdown", 8) == 0) {
+      _callbacks->saveWarmState();
       _board->powerOff();  // doesn't return
     } else if (memcmp(command, "reboot", 6) == 0) {
+      _callbacks->saveWarmState();
       _board->reboot();  // doesn't return
     } else if (memcmp(command, "clkreboot", 9) == 0) {
       // Reset clock
       getRTCClock()->setCurrentTime(1715770351);  // 15 May 2024, 8:50pm
+      _callbacks->clearWarmState();   // else the clock would be restored from it
       _board->reboot();  // doesn't return
      } else if (memcmp(command, "advert.zerohop", 14) == 0 && (command[14] == 0 || command[14] == ' ')) {
       // send zerohop advert
@@ -457,6 +474,12 @@ void CommonCLI::handleCommand(uint32_t sender_timestamp, char* command, char* re
       _callbacks->formatRadioStatsReply(reply);
     } else if (sender_timestamp == 0 && memcmp(command, "stats-core", 10) == 0 && (command[10] == 0 || command[10] == ' ')) {
       _callbacks->formatStatsReply(reply);
+    } else if (sender_timestamp == 0 && memcmp(command, "stats-tx", 8) == 0 && (command[8] == 0 || command[8] == ' ')) {
+      _callbacks->formatTxStatsReply(reply);
+    } else if (sender_timestamp == 0 && memcmp(command, "stats-latency", 13) == 0 && (command[13] == 0 || command[13] == ' ')) {
+      _callbacks->formatLatencyStatsReply(reply, command[13] == ' ' ? &command[14] : "");
+    } else if (sender_timestamp == 0 && memcmp(command, "stats-adverts", 13) == 0 && (command[13] == 0 || command[13] == ' ')) {
+      _callbacks->formatAdvertStatsReply(reply);
     } else {
       strcpy(reply, "Unknown command");
     }
@@ -654,6 +677,71 @@ void CommonCLI::handleSetCmd(uint32_t sender_timestamp, char* command, char* rep
       savePrefs();
       strcpy(reply, "OK");
     }
+  } else if (memcmp(config, "tx.weights ", 11) == 0) {
+    config += 11;
+    uint8_t weights[NUM_TX_CLASSES];
+    int n = 0;
+    while (n < NUM_TX_CLASSES && *config) {
+      int w = atoi(config);
+      if (w < 0 || w > 255) break;
+      weights[n++] = w;
+      while (*config && *config != ',') config++;   // skip to next
+      if (*config == ',') config++;
+    }
+    if (n != NUM_TX_CLASSES) {
+      strcpy(reply, "Error, expected: ack,direct,flood,bulk (each 0-255)");
+    } else if (!_callbacks->setTxClassWeights(weights)) {
+      strcpy(reply, "Error, not supported by this firmware");
+    } else {
+      memcpy(_prefs->tx_class_weights, weights, sizeof(weights));
+      savePrefs();
+      strcpy(reply, "OK");
+    }
+  } else if (memcmp(config, "duty.bands ", 11) == 0) {
+    bool enable = memcmp(&config[11], "on", 2) == 0;
+    if (!_callbacks->setDutyCycleBands(enable)) {
+      strcpy(reply, "Error, not supported by this firmware");
+    } else {
+      _prefs->duty_cycle_bands = enable;
+      savePrefs();
+      strcpy(reply, "OK");
+    }
+  } else if (memcmp(config, "flood.delay ", 12) == 0) {
+    uint8_t mode = 0xFF;
+    if (strcmp(&config[12], "adaptive") == 0) {
+      mode = FLOOD_DELAY_ADAPTIVE;
+    } else if (strcmp(&config[12], "fixed") == 0) {
+      mode = FLOOD_DELAY_FIXED;
+    }
+    if (mode == 0xFF) {
+      strcpy(reply, "Error, expected: fixed or adaptive");
+    } else if (!_callbacks->setFloodDelayMode(mode)) {
+      strcpy(reply, "Error, not supported by this firmware");
+    } else {
+      _prefs->flood_delay_mode = mode;
+      savePrefs();
+      strcpy(reply, "OK");
+    }
+  } else if (memcmp(config, "flood.suppress.snr ", 19) == 0) {
+    bool snr_weighted = memcmp(&config[19], "on", 2) == 0;
+    if (!_callbacks->setFloodSuppress(_prefs->flood_suppress, snr_weighted)) {
+      strcpy(reply, "Error, not supported by this firmware");
+    } else {
+      _prefs->flood_suppress_snr = snr_weighted;
+      savePrefs();
+      strcpy(reply, "OK");
+    }
+  } else if (memcmp(config, "flood.suppress ", 15) == 0) {
+    int k = atoi(&config[15]);
+    if (k < 0 || k > 8) {
+      strcpy(reply, "Error, must be 0-8 (0 = off)");
+    } else if (!_callbacks->setFloodSuppress(k, _prefs->flood_suppress_snr)) {
+      strcpy(reply, "Error, not supported by this firmware");
+    } else {
+      _prefs->flood_suppress = k;
+      savePrefs();
+      strcpy(reply, "OK");
+    }
   } else if (memcmp(config, "tx ", 3) == 0) {
     _prefs->tx_power_dbm = atoi(&config[3]);
     savePrefs();
@@ -804,6 +892,17 @@ void CommonCLI::handleGetCmd(uint32_t sender_timestamp, char* command, char* rep
     } else {
       strcpy(reply, "> strict");
     }
+  } else if (memcmp(config, "tx.weights", 10) == 0) {
+    sprintf(reply, "> %d,%d,%d,%d", (uint32_t)_prefs->tx_class_weights[TX_CLASS_ACK], (uint32_t)_prefs->tx_class_weights[TX_CLASS_DIRECT],
+            (uint32_t)_prefs->tx_class_weights[TX_CLASS_FLOOD], (uint32_t)_prefs->tx_class_weights[TX_CLASS_BULK]);
+  } else if (memcmp(config, "duty.bands", 10) == 0) {
+    sprintf(reply, "> %s", _prefs->duty_cycle_bands ? "on" : "off");
+  } else if (memcmp(config, "flood.delay", 11) == 0) {
+    sprintf(reply, "> %s", _prefs->flood_delay_mode == FLOOD_DELAY_ADAPTIVE ? "adaptive" : "fixed");
+  } else if (memcmp(config, "flood.suppress.snr", 18) == 0) {
+    sprintf(reply, "> %s", _prefs->flood_suppress_snr ? "on" : "off");
+  } else if (memcmp(config, "flood.suppress", 14) == 0) {
+    sprintf(reply, "> %d", (uint32_t)_prefs->flood_suppress);
   } else if (memcmp(config, "tx", 2) == 0 && (config[2] == 0 || config[2] == ' ')) {
     sprintf(reply, "> %d", (int32_t) _prefs->tx_power_dbm);
   } else if (memcmp(config, "freq", 4) == 0) {
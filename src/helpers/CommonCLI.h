@@ -5,6 +5,7 @@
 #include <helpers/SensorManager.h>
 #include <helpers/ClientACL.h>
 #include <helpers/RegionMap.h>
+#include <helpers/FloodDelayPolicy.h>
 
 #if defined(WITH_RS232_BRIDGE) || defined(WITH_ESPNOW_BRIDGE)
 #define WITH_BRIDGE
@@ -61,6 +62,11 @@ struct NodePrefs { // persisted to file
   uint8_t rx_boosted_gain; // power settings
   uint8_t path_hash_mode;   // which path mode to use when sending
   uint8_t loop_detect;
+  uint8_t tx_class_weights[NUM_TX_CLASSES];   // outbound airtime weights per TX_CLASS_*, 0 = strict priority
+  uint8_t flood_suppress;       // cancel queued flood rebroadcast after hearing this many duplicates, 0 = off
+  uint8_t flood_suppress_snr;   // boolean, weight the duplicates by their SNR
+  uint8_t flood_delay_mode;     // one of FLOOD_DELAY_*
+  uint8_t duty_cycle_bands;     // boolean, enforce the EU868 sub-band duty-cycle limits
 };
 
 class CommonCLICallbacks {
@@ -110,6 +116,41 @@ public:
   virtual void setRxBoostedGain(bool enable) {
     // no op by default
   };
+
+  virtual bool setTxClassWeights(const uint8_t weights[]) {
+    return false;   // not supported by default
+  };
+
+  virtual bool setFloodSuppress(uint8_t threshold, bool snr_weighted) {
+    return false;   // not supported by default
+  };
+
+  virtual bool setFloodDelayMode(uint8_t mode) {
+    return false;   // not supported by default
+  };
+
+  virtual bool setDutyCycleBands(bool enable) {
+    return false;   // not supported by default
+  };
+
+  virtual void formatTxStatsReply(char *reply) {
+    strcpy(reply, "Not supported");
+  };
+
+  virtual void formatLatencyStatsReply(char *reply, const char* stage) {
+    strcpy(reply, "Not supported");
+  };
+
+  virtual void formatAdvertStatsReply(char *reply) {
+    strcpy(reply, "Not supported");
+  };
+
+  virtual void saveWarmState() {
+    // no op by default
+  };
+  virtual void clearWarmState() {
+    // no op by default
+  };
 };
 
 class CommonCLI {
@@ -18,9 +18,13 @@ struct ContactInfo {
   int32_t gps_lat, gps_lon;    // 6 dec places
   uint32_t sync_since;
 
-  const uint8_t* getSharedSecret(const mesh::LocalIdentity& self_id) const {
+  const uint8_t* getSharedSecret(const mesh::LocalIdentity& self_id, mesh::SharedSecretCache* secrets=NULL) const {
     if (!shared_secret_valid) {
-      self_id.calcSharedSecret(shared_secret, id.pub_key);
+      if (secrets) {
+        secrets->calcSharedSecret(shared_secret, self_id, id);
+      } else {
+        self_id.calcSharedSecret(shared_secret, id.pub_key);
+      }
       shared_secret_valid = true;
     }
     return shared_secret;
@@ -0,0 +1,132 @@
+#include "DutyCycleLedger.h"
+#include <MeshCore.h>
+
+// ETSI EN 300 220 / ERC REC 70-03 (annex 1) sub-bands for non-specific SRDs
+const DutyCycleBand EU868_DUTY_CYCLE_BANDS[NUM_EU868_DUTY_CYCLE_BANDS] = {
+  { 863000, 865000,   1 },    // 0.1%
+  { 865000, 868000,  10 },    // 1%
+  { 868000, 868600,  10 },    // 1%  (g1)
+  { 868700, 869200,   1 },    // 0.1%  (g2)
+  { 869400, 869650, 100 },    // 10%  (g3)
+  { 869700, 870000,  10 },    // 1%  (g4)
+};
+
+DutyCycleLedger::DutyCycleLedger(const DutyCycleBand* bands, int num_bands, int max_entries, uint32_t window_millis) {
+  _bands = bands;
+  _num_bands = num_bands;
+  _ring = new Entry[max_entries];
+  _size = max_entries;
+  _head = _num = 0;
+  _window = window_millis;
+}
+
+int DutyCycleLedger::findBand(float freq) const {
+  uint32_t khz = (uint32_t)(freq * 1000.0f + 0.5f);
+  for (int i = 0; i < _num_bands; i++) {
+    if (khz >= _bands[i].freq_lo_khz && khz <= _bands[i].freq_hi_khz) return i;
+  }
+  return -1;  // not in a duty-cycle limited band
+}
+
+void DutyCycleLedger::removeAt(int i) {
+  for (int k = i; k > 0; k--) {   // shuffle the older entries up by one
+    entryAt(k) = entryAt(k - 1);
+  }
+  _head = (_head + 1) % _size;
+  _num--;
+}
+
+void DutyCycleLedger::mergeOldest() {
+  for (int i = 0; i < _num; i++) {
+    for (int j = i + 1; j < _num; j++) {
+      Entry& later = entryAt(j);
+      if (later.band != entryAt(i).band) continue;
+
+      // fold the older airtime into the later entry, keeping its END time. This only ever moves airtime
+      // later, so usage is over-estimated (never under) until it leaves the window.
+      uint32_t end = later.start + later.airtime;
+      uint32_t airtime = later.airtime + entryAt(i).airtime;
+      later.start = end - airtime;
+      later.airtime = airtime;
+      removeAt(i);
+      return;
+    }
+  }
+  MESH_DEBUG_PRINTLN("DutyCycleLedger: WARNING: no entries to merge, dropping oldest");
+  removeAt(0);
+}
+
+void DutyCycleLedger::prune(uint32_t now) {
+  while (_num > 0) {
+    const Entry& e = entryAt(0);
+    if ((int32_t)(e.start + e.airtime - (now - _window)) > 0) break;   // still (partly) in window
+    removeAt(0);
+  }
+}
+
+void DutyCycleLedger::recordTx(int band, uint32_t start, uint32_t airtime) {
+  if (band < 0 || band >= _num_bands) return;   // not a limited band
+
+  prune(start + airtime);
+  if (_num == _size) {
+    mergeOldest();
+  }
+  Entry& e = entryAt(_num++);
+  e.start = start;
+  e.airtime = airtime;
+  e.band = band;
+}
+
+uint32_t DutyCycleLedger::getUsedMillis(int band, uint32_t now) const {
+  if (band < 0 || band >= _num_bands) return 0;
+
+  int32_t win_start = -(int32_t)_window;   // relative to 'now'
+  uint32_t used = 0;
+  for (int i = 0; i < _num; i++) {
+    const Entry& e = entryAt(i);
+    if (e.band != band) continue;
+
+    int32_t a = (int32_t)(e.start - now);
+    int32_t b = a + e.airtime;
+    if (b > 0) b = 0;
+    if (a < win_start) a = win_start;
+    if (b > a) used += b - a;
+  }
+  return used;
+}
+
+uint32_t DutyCycleLedger::getLimitMillis(int band) const {
+  if (band < 0 || band >= _num_bands) return _window;
+  return (uint64_t)_window * _bands[band].limit_permille / 1000;
+}
+
+bool DutyCycleLedger::getEarliestTxTime(int band, uint32_t now, uint32_t airtime, uint32_t& when) const {
+  uint32_t limit = getLimitMillis(band);
+  if (airtime > limit) return false;   // can never be sent in this band
+
+  // a TX at 'now + d' is allowed if the (older) airtime in the window ending at 'now + d + airtime' is <= limit - airtime.
+  // Slide the window start forward, from where it is for d = 0, until enough old airtime has dropped out.
+  int32_t win_start = (int32_t)airtime - (int32_t)_window;   // relative to 'now'
+  int32_t excess = (int32_t)getUsedMillis(band, now + airtime) - (int32_t)(limit - airtime);
+
+  for (int i = 0; i < _num && excess > 0; i++) {
+    const Entry& e = entryAt(i);
+    if (e.band != band) continue;
+
+    int32_t a = (int32_t)(e.start - now);
+    int32_t b = a + e.airtime;
+    if (b <= win_start) continue;   // already out of window
+    if (a < win_start) a = win_start;
+
+    if (b - a >= excess) {
+      win_start = a + excess;
+      excess = 0;
+    } else {
+      excess -= b - a;
+      win_start = b;
+    }
+  }
+  int32_t d = win_start + (int32_t)_window - (int32_t)airtime;
+  when = now + (d > 0 ? d : 0);
+  return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifndef DUTY_LEDGER_SIZE
+  #define DUTY_LEDGER_SIZE   64    // max transmissions recorded (older ones are merged, conservatively)
+#endif
+
+/**
+ * \brief  A regulatory sub-band, with its duty-cycle limit.
+ */
+struct DutyCycleBand {
+  uint32_t freq_lo_khz, freq_hi_khz;
+  uint16_t limit_permille;   // eg. 10 = 1%
+};
+
+extern const DutyCycleBand EU868_DUTY_CYCLE_BANDS[];
+#define NUM_EU868_DUTY_CYCLE_BANDS   6
+
+/**
+ * \brief  An exact, rolling window record of transmit airtime, per sub-band. All arithmetic is in integer millis.
+ *        Unlike a token bucket, this can both prove compliance with a 'per hour' limit, and predict exactly when
+ *        the next transmission of a given airtime will be allowed.
+ */
+class DutyCycleLedger {
+  struct Entry {
+    uint32_t start;           // millis
+    uint32_t airtime : 24;    // millis
+    uint32_t band : 8;
+  };
+  const DutyCycleBand* _bands;
+  int _num_bands;
+  Entry* _ring;
+  int _size, _head, _num;   // _head is oldest entry
+  uint32_t _window;
+
+  Entry& entryAt(int i) const { return _ring[(_head + i) % _size]; }   // i = 0 is oldest
+  void removeAt(int i);
+  void mergeOldest();
+  void prune(uint32_t now);
+
+public:
+  DutyCycleLedger(const DutyCycleBand* bands, int num_bands, int max_entries=DUTY_LEDGER_SIZE, uint32_t window_millis=3600000);
+
+  /**
+   * \returns  index of the sub-band containing 'freq' (in MHz), or -1 if freq is not in a limited band
+   */
+  int findBand(float freq) const;
+
+  void recordTx(int band, uint32_t start, uint32_t airtime);
+
+  /**
+   * \returns  the airtime (millis) used in 'band' over the window ending at 'now'
+   */
+  uint32_t getUsedMillis(int band, uint32_t now) const;
+  uint32_t getLimitMillis(int band) const;
+
+  /**
+   * \brief  predicts the earliest time (at or after 'now') a transmission of 'airtime' millis is allowed in 'band'
+   * \returns  false if 'airtime' alone exceeds the limit, ie. can never be sent
+   */
+  bool getEarliestTxTime(int band, uint32_t now, uint32_t airtime, uint32_t& when) const;
+};
@@ -0,0 +1,189 @@
+#include "FairPacketManager.h"
+
+FairPacketManager::FairPacketManager(int pool_size, mesh::MillisecondClock* ms)
+  : pool(pool_size, ms), rx_queue(pool_size) {
+  for (int c = 0; c < NUM_TX_CLASSES; c++) {
+    send_queues[c] = new PacketTimerQueue(pool_size);   // any one class may hold the whole pool
+    _weights[c] = 0;
+    _deficit[c] = 0;
+  }
+  memset(_stats, 0, sizeof(_stats));
+  _next_seq = 0;
+  _rr_class = 0;
+  _rr_new_turn = true;
+}
+
+int FairPacketManager::classify(const mesh::Packet* packet) {
+  uint8_t type = packet->getPayloadType();
+  if (type == PAYLOAD_TYPE_ACK) return TX_CLASS_ACK;
+  if (type == PAYLOAD_TYPE_ADVERT || type == PAYLOAD_TYPE_TRACE) return TX_CLASS_BULK;
+  return packet->isRouteDirect() ? TX_CLASS_DIRECT : TX_CLASS_FLOOD;
+}
+
+uint32_t FairPacketManager::getAirtimeCost(const mesh::Packet* packet) {
+  // NOTE: LoRa airtime is close to linear in packet length (for given radio params), so bytes are a fair proxy
+  return packet->getRawLength() + FAIR_TX_OVERHEAD_BYTES;
+}
+
+int FairPacketManager::selectStrict(uint32_t now) {
+  int best = -1;
+  const PacketTimerQueue::Entry* best_e = NULL;
+  for (int c = 0; c < NUM_TX_CLASSES; c++) {
+    if (_weights[c] > 0) continue;
+
+    auto e = send_queues[c]->peek(now);
+    if (e && (best_e == NULL || e->priority < best_e->priority
+          || (e->priority == best_e->priority && (int32_t)(e->seq - best_e->seq) < 0))) {
+      best = c;
+      best_e = e;
+    }
+  }
+  return best;
+}
+
+int FairPacketManager::selectWeighted(uint32_t now) {
+  int num_idle = 0;
+  while (num_idle < NUM_TX_CLASSES) {
+    int c = _rr_class;
+    auto e = _weights[c] > 0 ? send_queues[c]->peek(now) : NULL;
+    if (e == NULL) {
+      _deficit[c] = 0;   // idle classes don't bank credit
+      num_idle++;
+    } else {
+      num_idle = 0;
+      if (_rr_new_turn) {
+        _deficit[c] += _weights[c] * FAIR_QUANTUM_BYTES;
+        _rr_new_turn = false;
+      }
+      uint32_t cost = getAirtimeCost(e->packet);
+      if (cost <= _deficit[c]) {
+        _deficit[c] -= cost;
+        return c;    // NOTE: turn continues, while this class still has credit
+      }
+      // else: not enough credit, carry it over to next round
+    }
+    _rr_class = (c + 1) % NUM_TX_CLASSES;
+    _rr_new_turn = true;
+  }
+  return -1;   // nothing due
+}
+
+mesh::Packet* FairPacketManager::allocNew() {
+  return pool.alloc();  // returns NULL if empty
+}
+
+void FairPacketManager::free(mesh::Packet* packet) {
+  pool.free(packet);
+}
+
+void FairPacketManager::queueOutbound(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for) {
+  if (send_queues[classify(packet)]->add(packet, priority, scheduled_for, _next_seq)) {
+    _next_seq++;
+  } else {
+    MESH_DEBUG_PRINTLN("queueOutbound: send queue full, dropping packet");
+    free(packet);
+  }
+}
+
+mesh::Packet* FairPacketManager::getNextOutbound(uint32_t now) {
+  int c = selectStrict(now);
+  if (c < 0) c = selectWeighted(now);
+  if (c < 0) return NULL;   // empty, or all items are still in the future
+
+  auto e = send_queues[c]->peek(now);
+  uint32_t wait = (int32_t)(now - e->scheduled_for) > 0 ? now - e->scheduled_for : 0;
+  auto s = &_stats[c];
+  s->n_sent++;
+  s->total_wait_millis += wait;
+  if (wait > s->max_wait_millis) s->max_wait_millis = wait;
+  if (wait > FAIR_STARVED_MILLIS) s->n_starved++;
+
+  return send_queues[c]->get(now);
+}
+
+int FairPacketManager::getOutboundCount(uint32_t now) const {
+  int n = 0;
+  for (int c = 0; c < NUM_TX_CLASSES; c++) {
+    n += send_queues[c]->countBefore(now);
+  }
+  return n;
+}
+
+int FairPacketManager::getOutboundTotal() const {
+  int n = 0;
+  for (int c = 0; c < NUM_TX_CLASSES; c++) {
+    n += send_queues[c]->count();
+  }
+  return n;
+}
+
+int FairPacketManager::getFreeCount() const {
+  return pool.getFreeCount();
+}
+
+mesh::Packet* FairPacketManager::getOutboundByIdx(int i) {
+  for (int c = 0; c < NUM_TX_CLASSES; c++) {
+    if (i < send_queues[c]->count()) return send_queues[c]->itemAt(i);
+    i -= send_queues[c]->count();
+  }
+  return NULL;  // invalid index
+}
+
+mesh::Packet* FairPacketManager::removeOutboundByIdx(int i) {
+  for (int c = 0; c < NUM_TX_CLASSES; c++) {
+    if (i < send_queues[c]->count()) return send_queues[c]->removeByIdx(i);
+    i -= send_queues[c]->count();
+  }
+  return NULL;  // invalid index
+}
+
+void FairPacketManager::queueInbound(mesh::Packet* packet, uint32_t scheduled_for) {
+  if (!rx_queue.add(packet, 0, scheduled_for)) {
+    MESH_DEBUG_PRINTLN("queueInbound: rx queue full, dropping packet");
+    free(packet);
+  }
+}
+
+mesh::Packet* FairPacketManager::getNextInbound(uint32_t now) {
+  return rx_queue.get(now);
+}
+
+bool FairPacketManager::getPoolStats(mesh::PacketPoolStats& dest) const {
+  pool.getStats(dest);
+  return true;
+}
+
+void FairPacketManager::resetPoolStats() {
+  pool.resetStats();
+}
+
+bool FairPacketManager::getNextOutboundTime(uint32_t now, uint32_t& scheduled_for) const {
+  bool found = false;
+  for (int c = 0; c < NUM_TX_CLASSES; c++) {
+    uint32_t t;
+    if (send_queues[c]->getNextDueTime(t) && (!found || (int32_t)(t - scheduled_for) < 0)) {
+      scheduled_for = t;
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool FairPacketManager::setTxClassWeights(const uint8_t weights[]) {
+  for (int c = 0; c < NUM_TX_CLASSES; c++) {
+    _weights[c] = weights[c];
+    _deficit[c] = 0;
+  }
+  _rr_new_turn = true;
+  return true;
+}
+
+bool FairPacketManager::getTxClassStats(int tx_class, mesh::TxClassStats& dest) const {
+  if (tx_class < 0 || tx_class >= NUM_TX_CLASSES) return false;
+  dest = _stats[tx_class];
+  return true;
+}
+
+void FairPacketManager::resetTxClassStats() {
+  memset(_stats, 0, sizeof(_stats));
+}
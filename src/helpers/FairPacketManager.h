@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Dispatcher.h>
+#include "PacketPool.h"
+#include "HeapPacketManager.h"
+
+#ifndef FAIR_QUANTUM_BYTES
+  #define FAIR_QUANTUM_BYTES        64    // airtime credit (in wire bytes) given per unit of weight, per round
+#endif
+#ifndef FAIR_TX_OVERHEAD_BYTES
+  #define FAIR_TX_OVERHEAD_BYTES    16    // approx. preamble + LoRa header/CRC airtime, in equivalent bytes
+#endif
+#ifndef FAIR_STARVED_MILLIS
+  #define FAIR_STARVED_MILLIS       10000
+#endif
+
+/**
+ * \brief  A PacketManager whose outbound scheduler shares airtime between traffic classes (see TX_CLASS_*),
+ *        using deficit round-robin over estimated airtime (not packet count), so that a sustained load of one
+ *        class (eg. routed direct traffic) can't starve the others (eg. relayed adverts and far-hop floods).
+ *        Classes with weight 0 are strict priority, and are always served first. With all weights 0 (the default)
+ *        this is the same plain priority order as HeapPacketManager.
+ *        Within a class, packets are served by priority, then arrival order.
+ */
+class FairPacketManager : public mesh::PacketManager {
+  PacketPool pool;
+  PacketTimerQueue* send_queues[NUM_TX_CLASSES];
+  PacketTimerQueue rx_queue;
+  uint8_t _weights[NUM_TX_CLASSES];
+  uint32_t _deficit[NUM_TX_CLASSES];
+  mesh::TxClassStats _stats[NUM_TX_CLASSES];
+  uint32_t _next_seq;
+  uint8_t _rr_class;
+  bool _rr_new_turn;
+
+  static int classify(const mesh::Packet* packet);
+  static uint32_t getAirtimeCost(const mesh::Packet* packet);
+  int selectStrict(uint32_t now);
+  int selectWeighted(uint32_t now);
+
+public:
+  FairPacketManager(int pool_size, mesh::MillisecondClock* ms=NULL);
+
+  mesh::Packet* allocNew() override;
+  void free(mesh::Packet* packet) override;
+  void queueOutbound(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for) override;
+  mesh::Packet* getNextOutbound(uint32_t now) override;
+  int getOutboundCount(uint32_t now) const override;
+  int getOutboundTotal() const override;
+  int getFreeCount() const override;
+  mesh::Packet* getOutboundByIdx(int i) override;
+  mesh::Packet* removeOutboundByIdx(int i) override;
+  void queueInbound(mesh::Packet* packet, uint32_t scheduled_for) override;
+  mesh::Packet* getNextInbound(uint32_t now) override;
+  bool getPoolStats(mesh::PacketPoolStats& dest) const override;
+  void resetPoolStats() override;
+  bool getNextOutboundTime(uint32_t now, uint32_t& scheduled_for) const override;
+  bool getNextInboundTime(uint32_t now, uint32_t& scheduled_for) const override { return rx_queue.getNextDueTime(scheduled_for); }
+  bool setTxClassWeights(const uint8_t weights[]) override;
+  bool getTxClassStats(int tx_class, mesh::TxClassStats& dest) const override;
+  void resetTxClassStats() override;
+};
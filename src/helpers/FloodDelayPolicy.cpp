@@ -0,0 +1,13 @@
+#include "FloodDelayPolicy.h"
+
+uint32_t AdaptiveFloodDelay::getDelay(mesh::RNG& rng, uint32_t slot_millis, float snr_margin, int num_neighbours) const {
+  int window = ADAPTIVE_DELAY_MIN_SLOTS + num_neighbours / 2;
+  if (window > ADAPTIVE_DELAY_MAX_SLOTS) window = ADAPTIVE_DELAY_MAX_SLOTS;
+
+  float f = snr_margin / ADAPTIVE_DELAY_SNR_RANGE;
+  if (f < 0.0f) f = 0.0f;
+  if (f > 1.0f) f = 1.0f;
+
+  uint32_t start = (uint32_t)(f * (window - ADAPTIVE_DELAY_JITTER_SLOTS) * slot_millis);
+  return start + rng.nextInt(0, ADAPTIVE_DELAY_JITTER_SLOTS*slot_millis + 1);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Mesh.h>
+
+#define FLOOD_DELAY_FIXED       0
+#define FLOOD_DELAY_ADAPTIVE    1
+
+#ifndef ADAPTIVE_DELAY_MIN_SLOTS
+  #define ADAPTIVE_DELAY_MIN_SLOTS     3    // contention window, with few/no neighbours
+#endif
+#ifndef ADAPTIVE_DELAY_MAX_SLOTS
+  #define ADAPTIVE_DELAY_MAX_SLOTS    10
+#endif
+#define ADAPTIVE_DELAY_JITTER_SLOTS    2
+#define ADAPTIVE_DELAY_SNR_RANGE    20.0f   // dB above the demodulation floor, ie. where window offset is maxed
+
+/**
+ * \brief  Chooses the random delay before re-broadcasting a flood packet (see Mesh::getRetransmitDelay())
+ */
+class FloodDelayPolicy {
+public:
+  /**
+   * \param  slot_millis      unit of delay, eg. packet's airtime x tx_delay_factor
+   * \param  snr_margin       dB above the demodulation floor (for the current SF) this copy was received at
+   * \param  num_neighbours   number of other repeaters recently heard directly
+   */
+  virtual uint32_t getDelay(mesh::RNG& rng, uint32_t slot_millis, float snr_margin, int num_neighbours) const = 0;
+
+  /**
+   * \returns  dB of 'snr' above the lowest SNR a LoRa packet can be demodulated at, with spreading factor 'sf'
+   */
+  static float calcSNRMargin(float snr, uint8_t sf) { return snr - (-7.5f - 2.5f * (sf - 7)); }
+};
+
+/**
+ * \brief  The original policy: uniformly random, 0 to 5 slots.
+ */
+class FixedFloodDelay : public FloodDelayPolicy {
+public:
+  uint32_t getDelay(mesh::RNG& rng, uint32_t slot_millis, float snr_margin, int num_neighbours) const override {
+    return rng.nextInt(0, 5*slot_millis + 1);
+  }
+};
+
+/**
+ * \brief  A contention window which widens with the number of neighbours (ie. likely contenders), where the copy's SNR
+ *        picks how far into the window this node starts. A weakly heard copy is probably from further away, so re-broadcasting
+ *        it reaches more new nodes, and it goes first. Strongly heard copies (well covered nodes) wait, and so are more likely
+ *        to hear enough duplicates to cancel (see Dispatcher::getFloodSuppressThreshold()).
+ */
+class AdaptiveFloodDelay : public FloodDelayPolicy {
+public:
+  uint32_t getDelay(mesh::RNG& rng, uint32_t slot_millis, float snr_margin, int num_neighbours) const override;
+};
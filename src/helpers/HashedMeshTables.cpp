@@ -0,0 +1,166 @@
+#include "HashedMeshTables.h"
+
+#define SLOT_EMPTY      0
+#define SLOT_DELETED    1   // tombstone, from clear() or expiry. Probes must continue past these
+#define SLOT_MIN_STAMP  2
+
+HashedMeshTables::HashedMeshTables(mesh::MillisecondClock& ms, int capacity, uint32_t max_age_secs) {
+  int n = 1;
+  while (n < capacity) n <<= 1;   // round up to power of 2
+  _ms = &ms;
+  _slots = new Entry[n];
+  memset(_slots, 0, sizeof(Entry) * n);
+  _mask = n - 1;
+  _max_age = max_age_secs * 1000;
+  _direct_dups = _flood_dups = _evicted = 0;
+}
+
+void HashedMeshTables::calcKey(const mesh::Packet* packet, uint8_t* key) {
+  if (packet->getPayloadType() == PAYLOAD_TYPE_ACK) {
+    // NOTE: ACKs are keyed by their CRC only (as retries of a message have same CRC), zero padded
+    memset(key, 0, MAX_HASH_SIZE);
+    memcpy(key, packet->payload, 4);
+  } else {
+    packet->calculateDedupeHash(key);
+  }
+}
+
+uint32_t HashedMeshTables::getStamp() const {
+  uint32_t now = _ms->getMillis();
+  return now < SLOT_MIN_STAMP ? SLOT_MIN_STAMP : now;
+}
+
+int HashedMeshTables::findSlot(const uint8_t* key, uint32_t now, bool& found) {
+  uint32_t h;
+  memcpy(&h, key, sizeof(h));   // keys are hash/CRC outputs, so already well distributed
+  uint64_t k;
+  memcpy(&k, key, sizeof(k));
+
+  int free_idx = -1, oldest_idx = -1;
+  uint32_t oldest_age = 0;
+  for (uint32_t p = 0; p < MESH_TABLES_MAX_PROBE && p <= _mask; p++) {
+    int i = (h + p) & _mask;
+    Entry& e = _slots[i];
+    if (e.seen_at == SLOT_EMPTY) {    // end of probe chain
+      found = false;
+      return free_idx >= 0 ? free_idx : i;
+    }
+    if (e.seen_at == SLOT_DELETED) {
+      if (free_idx < 0) free_idx = i;
+      continue;
+    }
+    uint32_t age = now - e.seen_at;
+    if (age >= _max_age) {
+      e.seen_at = SLOT_DELETED;   // expired
+      if (free_idx < 0) free_idx = i;
+      continue;
+    }
+    uint64_t ek;
+    memcpy(&ek, e.key, sizeof(ek));
+    if (ek == k) {
+      found = true;
+      return i;
+    }
+    if (oldest_idx < 0 || age > oldest_age) {
+      oldest_idx = i;
+      oldest_age = age;
+    }
+  }
+  found = false;
+  return free_idx >= 0 ? free_idx : oldest_idx;   // if probe window is full of live entries, the least recently seen
+}
+
+bool HashedMeshTables::hasSeen(const mesh::Packet* packet) {
+  uint8_t key[MAX_HASH_SIZE];
+  calcKey(packet, key);
+
+  uint32_t now = getStamp();
+  bool found;
+  Entry& e = _slots[findSlot(key, now, found)];
+  if (found) {
+    e.seen_at = now;   // refresh, so entries which keep being heard are not evicted
+    if (packet->isRouteDirect()) {
+      _direct_dups++;   // keep some stats
+    } else {
+      _flood_dups++;
+    }
+    return true;
+  }
+  if (e.seen_at >= SLOT_MIN_STAMP) {
+    _evicted++;   // replacing a live entry
+  }
+  memcpy(e.key, key, MAX_HASH_SIZE);
+  e.seen_at = now;
+  return false;
+}
+
+void HashedMeshTables::clear(const mesh::Packet* packet) {
+  uint8_t key[MAX_HASH_SIZE];
+  calcKey(packet, key);
+
+  bool found;
+  int i = findSlot(key, getStamp(), found);
+  if (found) {
+    _slots[i].seen_at = SLOT_DELETED;
+  }
+}
+
+int HashedMeshTables::getNumEntries() const {
+  uint32_t now = getStamp();
+  int n = 0;
+  for (uint32_t i = 0; i <= _mask; i++) {
+    uint32_t t = _slots[i].seen_at;
+    if (t >= SLOT_MIN_STAMP && now - t < _max_age) n++;
+  }
+  return n;
+}
+
+#define SAVED_ENTRY_SIZE  (MAX_HASH_SIZE + 2)   // key, age (secs)
+
+int HashedMeshTables::countYounger(uint32_t now, uint32_t age) const {
+  int n = 0;
+  for (uint32_t i = 0; i <= _mask; i++) {
+    uint32_t t = _slots[i].seen_at;
+    if (t >= SLOT_MIN_STAMP && now - t < age) n++;
+  }
+  return n;
+}
+
+int HashedMeshTables::saveTo(uint8_t* dest, int max_len) const {
+  uint32_t now = getStamp();
+  uint32_t cutoff = _max_age;
+  while (cutoff > 1000 && countYounger(now, cutoff) * SAVED_ENTRY_SIZE > max_len) {
+    cutoff /= 2;    // won't all fit, so drop the oldest
+  }
+
+  int len = 0;
+  for (uint32_t i = 0; i <= _mask && len + SAVED_ENTRY_SIZE <= max_len; i++) {
+    const Entry& e = _slots[i];
+    if (e.seen_at < SLOT_MIN_STAMP || now - e.seen_at >= cutoff) continue;
+
+    uint16_t age_secs = (now - e.seen_at) / 1000;
+    memcpy(&dest[len], e.key, MAX_HASH_SIZE); len += MAX_HASH_SIZE;
+    memcpy(&dest[len], &age_secs, 2); len += 2;
+  }
+  return len;
+}
+
+void HashedMeshTables::restoreFrom(const uint8_t* src, int len, uint32_t elapsed_secs) {
+  if (elapsed_secs >= _max_age / 1000) return;   // all would have expired
+
+  uint32_t now = getStamp();
+  for (int i = 0; i + SAVED_ENTRY_SIZE <= len; i += SAVED_ENTRY_SIZE) {
+    uint16_t age_secs;
+    memcpy(&age_secs, &src[i + MAX_HASH_SIZE], 2);
+    uint32_t age = (age_secs + elapsed_secs) * 1000;
+    if (age >= _max_age) continue;
+
+    bool found;
+    Entry& e = _slots[findSlot(&src[i], now, found)];
+    if (found) continue;   // already seen again since boot
+
+    memcpy(e.key, &src[i], MAX_HASH_SIZE);
+    e.seen_at = now - age;   // NOTE: may wrap 'before' millis() zero, which the age arithmetic is fine with
+    if (e.seen_at < SLOT_MIN_STAMP) e.seen_at = SLOT_MIN_STAMP;
+  }
+}
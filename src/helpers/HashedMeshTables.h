@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Mesh.h>
+
+#ifndef MESH_TABLES_CAPACITY
+  #if defined(CONFIG_IDF_TARGET_ESP32S3)
+    #define MESH_TABLES_CAPACITY    1024    // must be power of 2
+  #else
+    #define MESH_TABLES_CAPACITY     256
+  #endif
+#endif
+#ifndef MESH_TABLES_MAX_AGE_SECS
+  #define MESH_TABLES_MAX_AGE_SECS   900    // entries are forgotten after this, even if table not full
+#endif
+#ifndef MESH_TABLES_MAX_PROBE
+  #define MESH_TABLES_MAX_PROBE       32
+#endif
+
+/**
+ * \brief  A MeshTables using an open-addressed hash set (linear probing) of packet hashes and ACK CRCs, with
+ *        per-entry age stamps. Unlike the ring in SimpleMeshTables, entries expire by age, and when a probe
+ *        window is full the least recently seen entry in it is evicted, so a packet which keeps being heard
+ *        (eg. in a flood storm) is remembered for longer. Lookup/insert are O(1), bounded by MAX_PROBE.
+ */
+class HashedMeshTables : public mesh::MeshTables {
+  struct Entry {
+    uint8_t key[MAX_HASH_SIZE];
+    uint32_t seen_at;   // millis, or one of SLOT_*
+  };
+  mesh::MillisecondClock* _ms;
+  Entry* _slots;
+  uint32_t _mask;
+  uint32_t _max_age;
+  uint32_t _direct_dups, _flood_dups, _evicted;
+
+  static void calcKey(const mesh::Packet* packet, uint8_t* key);
+  uint32_t getStamp() const;
+  int findSlot(const uint8_t* key, uint32_t now, bool& found);
+  int countYounger(uint32_t now, uint32_t age) const;
+
+public:
+  HashedMeshTables(mesh::MillisecondClock& ms, int capacity=MESH_TABLES_CAPACITY, uint32_t max_age_secs=MESH_TABLES_MAX_AGE_SECS);
+
+  bool hasSeen(const mesh::Packet* packet) override;
+  void clear(const mesh::Packet* packet) override;
+
+  /**
+   * \brief  writes the live entries (most recently seen first, if they don't all fit), with their ages.
+   * \returns  number of bytes written
+   */
+  int saveTo(uint8_t* dest, int max_len) const;
+
+  /**
+   * \brief  re-inserts entries from saveTo(), eg. after a reboot.
+   * \param  elapsed_secs   time since saveTo() was called, which the entries are aged by
+   */
+  void restoreFrom(const uint8_t* src, int len, uint32_t elapsed_secs);
+
+  int getCapacity() const { return _mask + 1; }
+  int getNumEntries() const;
+
+  uint32_t getNumDirectDups() const { return _direct_dups; }
+  uint32_t getNumFloodDups() const { return _flood_dups; }
+  uint32_t getNumEvicted() const { return _evicted; }   // entries dropped before max age, for lack of space
+
+  void resetStats() { _direct_dups = _flood_dups = _evicted = 0; }
+};
@@ -0,0 +1,221 @@
+#include "HeapPacketManager.h"
+
+// 2's complement compare, handles millis() wrap-around (see Dispatcher::millisHasNowPassed())
+#define IS_TIME_BEFORE(a, b)   ((int32_t)((a) - (b)) < 0)
+#define IS_DUE(t, now)         ((int32_t)((t) - (now)) <= 0)
+
+PacketTimerQueue::PacketTimerQueue(int max_entries) {
+  _table = new Entry[max_entries];
+  _size = max_entries;
+  _num_ready = _num_waiting = 0;
+  _next_seq = 0;
+}
+
+bool PacketTimerQueue::isReadyBefore(const Entry& a, const Entry& b) {
+  if (a.priority != b.priority) return a.priority < b.priority;   // most important priority first
+  return IS_TIME_BEFORE(a.seq, b.seq);   // then by arrival order
+}
+
+bool PacketTimerQueue::isWaitingBefore(const Entry& a, const Entry& b) {
+  return IS_TIME_BEFORE(a.scheduled_for, b.scheduled_for);
+}
+
+void PacketTimerQueue::pushReady(const Entry& e) {
+  int i = _num_ready++;
+  while (i > 0) {   // sift up
+    int parent = (i - 1) / 2;
+    if (!isReadyBefore(e, ready(parent))) break;
+    ready(i) = ready(parent);
+    i = parent;
+  }
+  ready(i) = e;
+}
+
+void PacketTimerQueue::pushWaiting(const Entry& e) {
+  int i = _num_waiting++;
+  while (i > 0) {   // sift up
+    int parent = (i - 1) / 2;
+    if (!isWaitingBefore(e, waiting(parent))) break;
+    waiting(i) = waiting(parent);
+    i = parent;
+  }
+  waiting(i) = e;
+}
+
+PacketTimerQueue::Entry PacketTimerQueue::removeReadyAt(int i) {
+  Entry item = ready(i);
+  Entry last = ready(--_num_ready);
+  if (i < _num_ready) {
+    while (i > 0 && isReadyBefore(last, ready((i - 1) / 2))) {   // sift up
+      ready(i) = ready((i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+    for (;;) {    // sift down
+      int c = 2*i + 1;
+      if (c >= _num_ready) break;
+      if (c + 1 < _num_ready && isReadyBefore(ready(c + 1), ready(c))) c++;
+      if (!isReadyBefore(ready(c), last)) break;
+      ready(i) = ready(c);
+      i = c;
+    }
+    ready(i) = last;
+  }
+  return item;
+}
+
+PacketTimerQueue::Entry PacketTimerQueue::removeWaitingAt(int i) {
+  Entry item = waiting(i);
+  Entry last = waiting(--_num_waiting);
+  if (i < _num_waiting) {
+    while (i > 0 && isWaitingBefore(last, waiting((i - 1) / 2))) {   // sift up
+      waiting(i) = waiting((i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+    for (;;) {    // sift down
+      int c = 2*i + 1;
+      if (c >= _num_waiting) break;
+      if (c + 1 < _num_waiting && isWaitingBefore(waiting(c + 1), waiting(c))) c++;
+      if (!isWaitingBefore(waiting(c), last)) break;
+      waiting(i) = waiting(c);
+      i = c;
+    }
+    waiting(i) = last;
+  }
+  return item;
+}
+
+void PacketTimerQueue::promoteDue(uint32_t now) {
+  while (_num_waiting > 0 && IS_DUE(waiting(0).scheduled_for, now)) {
+    pushReady(removeWaitingAt(0));
+  }
+}
+
+int PacketTimerQueue::countDueWaiting(int i, uint32_t now) const {
+  if (i >= _num_waiting || !IS_DUE(waiting(i).scheduled_for, now)) return 0;   // this whole sub-tree is in the future
+  return 1 + countDueWaiting(2*i + 1, now) + countDueWaiting(2*i + 2, now);
+}
+
+bool PacketTimerQueue::add(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for) {
+  if (!add(packet, priority, scheduled_for, _next_seq)) return false;
+  _next_seq++;
+  return true;
+}
+
+bool PacketTimerQueue::add(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for, uint32_t seq) {
+  if (count() == _size) {
+    return false;
+  }
+  Entry e;
+  e.packet = packet;
+  e.priority = priority;
+  e.scheduled_for = scheduled_for;
+  e.seq = seq;
+  pushWaiting(e);
+  return true;
+}
+
+mesh::Packet* PacketTimerQueue::get(uint32_t now) {
+  promoteDue(now);
+  if (_num_ready == 0) return NULL;   // empty, or all items are still in the future
+
+  return removeReadyAt(0).packet;
+}
+
+const PacketTimerQueue::Entry* PacketTimerQueue::peek(uint32_t now) {
+  promoteDue(now);
+  return _num_ready > 0 ? &ready(0) : NULL;
+}
+
+int PacketTimerQueue::countBefore(uint32_t now) const {
+  if (now == 0xFFFFFFFF) return count();  // sentinel: count all entries regardless of schedule
+
+  return _num_ready + countDueWaiting(0, now);   // only visits the due entries (and their direct children)
+}
+
+bool PacketTimerQueue::hasDue(uint32_t now) const {
+  return _num_ready > 0 || (_num_waiting > 0 && IS_DUE(waiting(0).scheduled_for, now));
+}
+
+bool PacketTimerQueue::getNextDueTime(uint32_t& scheduled_for) const {
+  if (_num_ready > 0) {
+    scheduled_for = ready(0).scheduled_for;   // already due (ie. in the past)
+  } else if (_num_waiting > 0) {
+    scheduled_for = waiting(0).scheduled_for;
+  } else {
+    return false;   // empty
+  }
+  return true;
+}
+
+mesh::Packet* PacketTimerQueue::itemAt(int i) const {
+  if (i < _num_ready) return ready(i).packet;
+  return waiting(i - _num_ready).packet;
+}
+
+mesh::Packet* PacketTimerQueue::removeByIdx(int i) {
+  if (i < 0 || i >= count()) return NULL;  // invalid index
+
+  if (i < _num_ready) return removeReadyAt(i).packet;
+  return removeWaitingAt(i - _num_ready).packet;
+}
+
+HeapPacketManager::HeapPacketManager(int pool_size, mesh::MillisecondClock* ms)
+  : pool(pool_size, ms), send_queue(pool_size), rx_queue(pool_size) {
+}
+
+mesh::Packet* HeapPacketManager::allocNew() {
+  return pool.alloc();  // returns NULL if empty
+}
+
+void HeapPacketManager::free(mesh::Packet* packet) {
+  pool.free(packet);
+}
+
+void HeapPacketManager::queueOutbound(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for) {
+  if (!send_queue.add(packet, priority, scheduled_for)) {
+    MESH_DEBUG_PRINTLN("queueOutbound: send queue full, dropping packet");
+    free(packet);
+  }
+}
+
+mesh::Packet* HeapPacketManager::getNextOutbound(uint32_t now) {
+  return send_queue.get(now);
+}
+
+int HeapPacketManager::getOutboundCount(uint32_t now) const {
+  return send_queue.countBefore(now);
+}
+
+int HeapPacketManager::getOutboundTotal() const {
+  return send_queue.count();
+}
+
+int HeapPacketManager::getFreeCount() const {
+  return pool.getFreeCount();
+}
+
+bool HeapPacketManager::getPoolStats(mesh::PacketPoolStats& dest) const {
+  pool.getStats(dest);
+  return true;
+}
+
+void HeapPacketManager::resetPoolStats() {
+  pool.resetStats();
+}
+
+mesh::Packet* HeapPacketManager::getOutboundByIdx(int i) {
+  return send_queue.itemAt(i);
+}
+mesh::Packet* HeapPacketManager::removeOutboundByIdx(int i) {
+  return send_queue.removeByIdx(i);
+}
+
+void HeapPacketManager::queueInbound(mesh::Packet* packet, uint32_t scheduled_for) {
+  if (!rx_queue.add(packet, 0, scheduled_for)) {
+    MESH_DEBUG_PRINTLN("queueInbound: rx queue full, dropping packet");
+    free(packet);
+  }
+}
+mesh::Packet* HeapPacketManager::getNextInbound(uint32_t now) {
+  return rx_queue.get(now);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Dispatcher.h>
+#include "PacketPool.h"
+
+/**
+ * \brief  A two-level packet queue. Entries wait in a min-heap keyed by 'scheduled_for' until they are due,
+ *        then migrate to a second min-heap keyed by (priority, arrival order).
+ *        add/get/removeByIdx are O(log n), and the 'anything due?' and 'next due time' queries are O(1).
+ *        Both heaps share one table: the 'ready' heap grows up from the front, the 'waiting' heap down from the back.
+ */
+class PacketTimerQueue {
+public:
+  struct Entry {
+    mesh::Packet* packet;
+    uint32_t scheduled_for;
+    uint32_t seq;        // arrival order, so equal priorities are served FIFO
+    uint8_t priority;
+  };
+
+private:
+  Entry* _table;
+  int _size, _num_ready, _num_waiting;
+  uint32_t _next_seq;
+
+  Entry& ready(int i) const { return _table[i]; }
+  Entry& waiting(int i) const { return _table[_size - 1 - i]; }
+
+  static bool isReadyBefore(const Entry& a, const Entry& b);
+  static bool isWaitingBefore(const Entry& a, const Entry& b);
+
+  void pushReady(const Entry& e);
+  void pushWaiting(const Entry& e);
+  Entry removeReadyAt(int i);
+  Entry removeWaitingAt(int i);
+  void promoteDue(uint32_t now);
+  int countDueWaiting(int i, uint32_t now) const;
+
+public:
+  PacketTimerQueue(int max_entries);
+  mesh::Packet* get(uint32_t now);
+  const Entry* peek(uint32_t now);    // the entry get() would return next (or NULL), without removing it
+  bool add(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for);
+  bool add(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for, uint32_t seq);
+  int count() const { return _num_ready + _num_waiting; }
+  int countBefore(uint32_t now) const;
+  bool hasDue(uint32_t now) const;
+  bool getNextDueTime(uint32_t& scheduled_for) const;
+  mesh::Packet* itemAt(int i) const;
+  mesh::Packet* removeByIdx(int i);
+};
+
+/**
+ * \brief  A PacketManager with the same static Packet pool as StaticPoolPacketManager, but with heap-ordered
+ *        inbound and outbound queues, for nodes where the send queue is frequently near the pool size.
+ */
+class HeapPacketManager : public mesh::PacketManager {
+  PacketPool pool;
+  PacketTimerQueue send_queue, rx_queue;
+
+public:
+  HeapPacketManager(int pool_size, mesh::MillisecondClock* ms=NULL);
+
+  mesh::Packet* allocNew() override;
+  void free(mesh::Packet* packet) override;
+  void queueOutbound(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for) override;
+  mesh::Packet* getNextOutbound(uint32_t now) override;
+  int getOutboundCount(uint32_t now) const override;
+  int getOutboundTotal() const override;
+  int getFreeCount() const override;
+  mesh::Packet* getOutboundByIdx(int i) override;
+  mesh::Packet* removeOutboundByIdx(int i) override;
+  void queueInbound(mesh::Packet* packet, uint32_t scheduled_for) override;
+  mesh::Packet* getNextInbound(uint32_t now) override;
+  bool getPoolStats(mesh::PacketPoolStats& dest) const override;
+  void resetPoolStats() override;
+
+  bool getNextOutboundTime(uint32_t now, uint32_t& scheduled_for) const override { return send_queue.getNextDueTime(scheduled_for); }
+  bool getNextInboundTime(uint32_t now, uint32_t& scheduled_for) const override { return rx_queue.getNextDueTime(scheduled_for); }
+};
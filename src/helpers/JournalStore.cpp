@@ -0,0 +1,235 @@
+#include "JournalStore.h"
+#include <Utils.h>
+
+#define JOURNAL_MAGIC         0x4C4E524A   // "JRNL"
+#define JOURNAL_HEADER_SIZE   12           // magic, gen, check
+#define JOURNAL_COMMIT        0            // record type, marks end of snapshot
+#define RECORD_OVERHEAD       6            // type, len, check (4)
+
+static File openRead(FILESYSTEM* _fs, const char* filename) {
+  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+    return _fs->open(filename, FILE_O_READ);
+  #elif defined(RP2040_PLATFORM)
+    return _fs->open(filename, "r");
+  #else
+    return _fs->open(filename, "r", false);
+  #endif
+}
+
+static File openWrite(FILESYSTEM* _fs, const char* filename) {
+  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+    _fs->remove(filename);
+    return _fs->open(filename, FILE_O_WRITE);
+  #elif defined(RP2040_PLATFORM)
+    return _fs->open(filename, "w");
+  #else
+    return _fs->open(filename, "w", true);
+  #endif
+}
+
+static File openAppend(FILESYSTEM* _fs, const char* filename) {
+  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+    return _fs->open(filename, FILE_O_WRITE);   // NOTE: positioned at end
+  #elif defined(RP2040_PLATFORM)
+    return _fs->open(filename, "a");
+  #else
+    return _fs->open(filename, "a", false);
+  #endif
+}
+
+static uint32_t calcCheck(const uint8_t* buf, int len) {
+  static const uint8_t key[16] = { 0 };   // just detecting torn/garbage records, not tampering
+  return (uint32_t) mesh::Utils::sipHash(key, buf, len);
+}
+
+static size_t encodeRecord(uint8_t* dest, uint8_t type, const uint8_t* data, int len) {
+  dest[0] = type;
+  dest[1] = len;
+  if (len > 0) memcpy(&dest[2], data, len);
+  uint32_t check = calcCheck(dest, 2 + len);
+  memcpy(&dest[2 + len], &check, 4);
+  return RECORD_OVERHEAD + len;
+}
+
+JournalStore::JournalStore(FILESYSTEM* fs, const char* name) {
+  _fs = fs;
+  _name = name;
+  _active = 0;
+  _gen = 0;
+  _snapshot_len = _journal_len = 0;
+  _torn = false;
+  _compact = NULL;
+  _compact_len = 0;
+}
+
+void JournalStore::getFilename(char* dest, char which) const {
+  sprintf(dest, "%s%c", _name, which);
+}
+
+// returns: -1 = no file, 0 = incomplete/invalid, 1 = has a complete snapshot
+int JournalStore::scan(char which, uint32_t& gen, JournalVisitor* visitor) {
+  char filename[32];
+  getFilename(filename, which);
+  if (!_fs->exists(filename)) return -1;
+
+  File file = openRead(_fs, filename);
+  if (!file) return 0;
+
+  int result = 0;
+  uint8_t buf[RECORD_OVERHEAD + JOURNAL_MAX_RECORD_LEN];
+  uint32_t magic, check;
+  if (file.read(buf, JOURNAL_HEADER_SIZE) == JOURNAL_HEADER_SIZE) {
+    memcpy(&magic, &buf[0], 4);
+    memcpy(&gen, &buf[4], 4);
+    memcpy(&check, &buf[8], 4);
+  } else {
+    magic = 0;
+  }
+  if (magic == JOURNAL_MAGIC && check == calcCheck(buf, 8)) {
+    uint32_t pos = JOURNAL_HEADER_SIZE, snapshot_len = 0;
+    while (file.read(buf, 2) == 2) {
+      int len = buf[1];
+      size_t body_len = len + 4;   // data, check
+      if (file.read(&buf[2], body_len) != body_len) break;   // torn
+
+      memcpy(&check, &buf[2 + len], 4);
+      if (check != calcCheck(buf, 2 + len)) break;   // torn, or garbage
+      pos += RECORD_OVERHEAD + len;
+
+      if (buf[0] == JOURNAL_COMMIT) {
+        if (result == 0) {
+          result = 1;
+          snapshot_len = pos;
+          if (visitor == NULL) break;   // only checking snapshot is complete
+        }
+      } else if (visitor) {
+        visitor->onJournalRecord(buf[0], &buf[2], len);
+      }
+    }
+    if (visitor) {
+      _snapshot_len = snapshot_len;
+      _journal_len = pos - snapshot_len;
+      _torn = pos < file.size();
+    }
+  }
+  file.close();
+  return result;
+}
+
+bool JournalStore::load(JournalVisitor* visitor) {
+  uint32_t gen_a = 0, gen_b = 0;
+  int a = scan('a', gen_a, NULL);
+  int b = scan('b', gen_b, NULL);
+
+  // use the latest complete one. NOTE: if both are complete, a compact() was interrupted just before removing old one
+  char which = 0;
+  if (a > 0 && (b <= 0 || (int32_t)(gen_a - gen_b) > 0)) {
+    which = 'a';
+  } else if (b > 0) {
+    which = 'b';
+  }
+
+  char filename[32];
+  if (a >= 0 && which != 'a') {
+    getFilename(filename, 'a');
+    _fs->remove(filename);
+  }
+  if (b >= 0 && which != 'b') {
+    getFilename(filename, 'b');
+    _fs->remove(filename);
+  }
+
+  _active = which;
+  _torn = false;
+  _snapshot_len = _journal_len = 0;
+  if (which == 0) {
+    _gen = 0;
+    return false;
+  }
+  _gen = which == 'a' ? gen_a : gen_b;
+  scan(which, _gen, visitor);
+  return true;
+}
+
+bool JournalStore::needsCompact() const {
+  if (_active == 0 || _torn) return true;   // nothing to append to, or appending would follow a torn record
+
+  uint32_t limit = _snapshot_len > JOURNAL_MIN_COMPACT_SIZE ? _snapshot_len : JOURNAL_MIN_COMPACT_SIZE;
+  return _journal_len > limit;
+}
+
+bool JournalStore::append(uint8_t type, const uint8_t* data, int len) {
+  if (_active == 0 || _torn || type == JOURNAL_COMMIT || len > JOURNAL_MAX_RECORD_LEN) return false;
+
+  char filename[32];
+  getFilename(filename, _active);
+  File file = openAppend(_fs, filename);
+  if (!file) return false;
+
+  uint8_t buf[RECORD_OVERHEAD + JOURNAL_MAX_RECORD_LEN];
+  size_t n = encodeRecord(buf, type, data, len);
+  bool success = (file.write(buf, n) == n);
+  file.close();
+
+  if (success) {
+    _journal_len += n;
+  } else {
+    _torn = true;   // must compact() before appending anything else
+  }
+  return success;
+}
+
+bool JournalStore::writeSnapshotRecord(uint8_t type, const uint8_t* data, int len) {
+  if (_compact == NULL || len > JOURNAL_MAX_RECORD_LEN) return false;
+
+  uint8_t buf[RECORD_OVERHEAD + JOURNAL_MAX_RECORD_LEN];
+  size_t n = encodeRecord(buf, type, data, len);
+  if (_compact->write(buf, n) != n) return false;
+
+  _compact_len += n;
+  return true;
+}
+
+bool JournalStore::compact(JournalSnapshotSource* src) {
+  char which = _active == 'a' ? 'b' : 'a';
+  char filename[32];
+  getFilename(filename, which);
+
+  File file = openWrite(_fs, filename);
+  if (!file) return false;
+
+  uint8_t hdr[JOURNAL_HEADER_SIZE];
+  uint32_t magic = JOURNAL_MAGIC, gen = _gen + 1;
+  memcpy(&hdr[0], &magic, 4);
+  memcpy(&hdr[4], &gen, 4);
+  uint32_t check = calcCheck(hdr, 8);
+  memcpy(&hdr[8], &check, 4);
+  bool success = (file.write(hdr, JOURNAL_HEADER_SIZE) == JOURNAL_HEADER_SIZE);
+
+  _compact = &file;
+  _compact_len = JOURNAL_HEADER_SIZE;
+  success = success && src->writeSnapshot(*this);
+  _compact = NULL;
+
+  uint8_t commit[RECORD_OVERHEAD];
+  size_t n = encodeRecord(commit, JOURNAL_COMMIT, NULL, 0);
+  success = success && (file.write(commit, n) == n);
+  file.close();
+
+  if (!success) {
+    _fs->remove(filename);   // keep the current file
+    return false;
+  }
+
+  if (_active) {   // new snapshot is complete, so old file can go
+    char old_filename[32];
+    getFilename(old_filename, _active);
+    _fs->remove(old_filename);
+  }
+  _active = which;
+  _gen = gen;
+  _snapshot_len = _compact_len + n;
+  _journal_len = 0;
+  _torn = false;
+  return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>   // needed for PlatformIO
+#include <helpers/IdentityStore.h>
+
+#ifndef JOURNAL_MIN_COMPACT_SIZE
+  #define JOURNAL_MIN_COMPACT_SIZE   4096   // journal is allowed to grow to this, or to size of snapshot, whichever is larger
+#endif
+
+#define JOURNAL_MAX_RECORD_LEN   255
+
+class JournalStore;
+
+class JournalVisitor {
+public:
+  virtual void onJournalRecord(uint8_t type, const uint8_t* data, int len) = 0;
+};
+
+class JournalSnapshotSource {
+public:
+  virtual bool writeSnapshot(JournalStore& store) = 0;   // calls store.writeSnapshotRecord() for every record of current state
+};
+
+/**
+ * \brief  A file of typed records: a snapshot of the full state, then a journal of changes appended since.
+ *        Appending one changed record is cheap, and when the journal has grown too large the state is compacted,
+ *        ie. written in full as a new snapshot. The file alternates between two names (base name + 'a' or 'b'),
+ *        with a generation number in the header, and the old file is only removed once the new snapshot is
+ *        complete. Each record has a checksum, so a record torn by power loss (and anything after) is ignored.
+ *        NOTE: records must be idempotent (eg. 'set X' or 'delete X'), as the caller may re-apply them.
+ */
+class JournalStore {
+  FILESYSTEM* _fs;
+  const char* _name;
+  char _active;             // 'a' or 'b', or 0 if no file yet
+  uint32_t _gen;
+  uint32_t _snapshot_len, _journal_len;
+  bool _torn;               // last record could not be read or written
+  File* _compact;           // new snapshot being written, in compact()
+  uint32_t _compact_len;
+
+  void getFilename(char* dest, char which) const;
+  int scan(char which, uint32_t& gen, JournalVisitor* visitor);
+
+public:
+  JournalStore(FILESYSTEM* fs, const char* name);
+
+  /**
+   * \brief  replays the latest complete snapshot to 'visitor', then its journal, up to any torn record.
+   * \returns  false if there is no complete snapshot (visitor is not called)
+   */
+  bool load(JournalVisitor* visitor);
+
+  bool needsCompact() const;
+  bool append(uint8_t type, const uint8_t* data, int len);
+
+  /**
+   * \brief  writes a new snapshot, from 'src', and starts a new (empty) journal
+   * \returns  false if the new snapshot could not be written (the current one is kept)
+   */
+  bool compact(JournalSnapshotSource* src);
+  bool writeSnapshotRecord(uint8_t type, const uint8_t* data, int len);   // only from JournalSnapshotSource
+
+  uint32_t getJournalLen() const { return _journal_len; }
+};
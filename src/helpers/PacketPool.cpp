@@ -0,0 +1,109 @@
+#include "PacketPool.h"
+
+#define POISON_BYTE   0xDB
+
+PacketPool::PacketPool(int size, mesh::MillisecondClock* ms) {
+  _packets = new mesh::Packet[size];
+  _size = size;
+  _ms = ms;
+  _free_head = NULL;
+  for (int i = size - 1; i >= 0; i--) {   // chain all the Packets into the free-list
+    setLink(&_packets[i], _free_head);
+    _free_head = &_packets[i];
+  #if PACKET_POOL_DEBUG
+    memset(&_packets[i].payload[sizeof(mesh::Packet*)], POISON_BYTE, sizeof(_packets[i].payload) - sizeof(mesh::Packet*));
+  #endif
+  }
+  _num_free = size;
+  _max_in_use = 0;
+  _n_alloc_fails = 0;
+  _n_bad_frees = 0;
+  _empty_millis = 0;
+  _empty_since = 0;
+}
+
+mesh::Packet* PacketPool::getLink(const mesh::Packet* packet) {
+  mesh::Packet* next;
+  memcpy(&next, packet->payload, sizeof(next));
+  return next;
+}
+
+void PacketPool::setLink(mesh::Packet* packet, mesh::Packet* next) {
+  memcpy(packet->payload, &next, sizeof(next));
+}
+
+mesh::Packet* PacketPool::alloc() {
+  mesh::Packet* packet = _free_head;
+  if (packet == NULL) {
+    _n_alloc_fails++;
+    return NULL;
+  }
+  _free_head = getLink(packet);
+  _num_free--;
+  packet->invalidateHash();   // NOTE: payload was used for free-list link
+
+#if PACKET_POOL_DEBUG
+  for (size_t i = sizeof(mesh::Packet*); i < sizeof(packet->payload); i++) {
+    if (packet->payload[i] != POISON_BYTE) {
+      MESH_DEBUG_PRINTLN("PacketPool::alloc(): WARNING: free Packet was modified (use after free?)");
+      break;
+    }
+  }
+#endif
+
+  int in_use = _size - _num_free;
+  if (in_use > _max_in_use) {
+    _max_in_use = in_use;
+  }
+  if (_num_free == 0 && _ms) {
+    _empty_since = _ms->getMillis();
+  }
+  return packet;
+}
+
+void PacketPool::free(mesh::Packet* packet) {
+#if PACKET_POOL_DEBUG
+  if (packet < _packets || packet >= &_packets[_size]) {
+    MESH_DEBUG_PRINTLN("PacketPool::free(): ERROR: Packet is not from this pool!");
+    _n_bad_frees++;
+    return;
+  }
+  for (const mesh::Packet* p = _free_head; p; p = getLink(p)) {
+    if (p == packet) {
+      MESH_DEBUG_PRINTLN("PacketPool::free(): ERROR: double free of Packet!");
+      _n_bad_frees++;
+      return;
+    }
+  }
+  memset(&packet->payload[sizeof(mesh::Packet*)], POISON_BYTE, sizeof(packet->payload) - sizeof(mesh::Packet*));
+#endif
+
+  if (_num_free == 0 && _ms) {
+    _empty_millis += _ms->getMillis() - _empty_since;
+  }
+  setLink(packet, _free_head);
+  _free_head = packet;
+  _num_free++;
+}
+
+void PacketPool::getStats(mesh::PacketPoolStats& dest) const {
+  dest.pool_size = _size;
+  dest.num_free = _num_free;
+  dest.max_in_use = _max_in_use;
+  dest.n_alloc_fails = _n_alloc_fails;
+  dest.n_bad_frees = _n_bad_frees;
+  dest.empty_millis = _empty_millis;
+  if (_num_free == 0 && _ms) {
+    dest.empty_millis += _ms->getMillis() - _empty_since;   // include the current 'empty' period
+  }
+}
+
+void PacketPool::resetStats() {
+  _max_in_use = _size - _num_free;
+  _n_alloc_fails = 0;
+  _n_bad_frees = 0;
+  _empty_millis = 0;
+  if (_num_free == 0 && _ms) {
+    _empty_since = _ms->getMillis();
+  }
+}
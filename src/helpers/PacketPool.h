@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Dispatcher.h>
+
+#ifndef PACKET_POOL_DEBUG
+  #if MESH_DEBUG
+    #define PACKET_POOL_DEBUG  1    // poison freed Packets, and detect double-free
+  #endif
+#endif
+
+/**
+ * \brief  A fixed pool of Packets, with an intrusive LIFO free-list (link is kept in the payload of free Packets).
+ *        alloc() and free() are O(1).
+ */
+class PacketPool {
+  mesh::Packet* _packets;
+  mesh::Packet* _free_head;
+  int _size, _num_free;
+  mesh::MillisecondClock* _ms;
+  int _max_in_use;
+  uint32_t _n_alloc_fails;
+  uint32_t _n_bad_frees;
+  uint32_t _empty_millis;
+  unsigned long _empty_since;
+
+  static mesh::Packet* getLink(const mesh::Packet* packet);
+  static void setLink(mesh::Packet* packet, mesh::Packet* next);
+
+public:
+  /**
+   * \param  ms  (optional) clock, for tracking time spent with zero free Packets
+   */
+  PacketPool(int size, mesh::MillisecondClock* ms=NULL);
+
+  mesh::Packet* alloc();   // returns NULL if empty
+  void free(mesh::Packet* packet);
+
+  int getFreeCount() const { return _num_free; }
+  int getSize() const { return _size; }
+  void getStats(mesh::PacketPoolStats& dest) const;
+  void resetStats();
+};
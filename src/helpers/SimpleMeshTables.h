@@ -61,7 +61,7 @@ public:
     }
 
     uint8_t hash[MAX_HASH_SIZE];
-    packet->calculatePacketHash(hash);
+    packet->calculateDedupeHash(hash);
 
     const uint8_t* sp = _hashes;
     for (int i = 0; i < MAX_PACKET_HASHES; i++, sp += MAX_HASH_SIZE) {
@@ -92,7 +92,7 @@ public:
       }
     } else {
       uint8_t hash[MAX_HASH_SIZE];
-      packet->calculatePacketHash(hash);
+      packet->calculateDedupeHash(hash);
 
       uint8_t* sp = _hashes;
       for (int i = 0; i < MAX_PACKET_HASHES; i++, sp += MAX_HASH_SIZE) {
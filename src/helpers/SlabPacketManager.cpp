@@ -0,0 +1,248 @@
+#include "SlabPacketManager.h"
+
+PacketSlab::PacketSlab(int num_bufs, int buf_size) {
+  if (buf_size < (int)sizeof(uint8_t*)) buf_size = sizeof(uint8_t*);
+  _buf_size = buf_size;
+  _bufs = new uint8_t[num_bufs * buf_size];
+  _free_head = NULL;
+  _num_free = 0;
+  for (int i = num_bufs - 1; i >= 0; i--) {   // chain all buffers into the free-list
+    free(&_bufs[i * buf_size]);
+  }
+}
+
+uint8_t* PacketSlab::alloc() {
+  uint8_t* buf = _free_head;
+  if (buf) {
+    memcpy(&_free_head, buf, sizeof(_free_head));   // link is stored in first bytes of free buffer
+    _num_free--;
+  }
+  return buf;
+}
+
+void PacketSlab::free(uint8_t* buf) {
+  memcpy(buf, &_free_head, sizeof(_free_head));
+  _free_head = buf;
+  _num_free++;
+}
+
+SlabPacketManager::SlabPacketManager(int num_working, int num_small, int num_large, mesh::MillisecondClock* ms)
+  : pool(num_working, ms), small_slab(num_small, SLAB_SMALL_SIZE), large_slab(num_large, SLAB_LARGE_SIZE) {
+  _num_records = num_small + num_large;
+  _records = new QueuedRecord[_num_records];
+  memset(_records, 0, sizeof(QueuedRecord) * _num_records);
+  _num_outbound = _num_inbound = 0;
+  _next_seq = 0;
+}
+
+bool SlabPacketManager::enqueue(mesh::Packet* packet, bool is_inbound, uint8_t priority, uint32_t scheduled_for) {
+  int len = packet->getRawLength();
+  bool is_large = false;
+  uint8_t* buf = NULL;
+  if (len <= small_slab.getBufSize()) {
+    buf = small_slab.alloc();
+  }
+  if (buf == NULL && len <= large_slab.getBufSize()) {
+    buf = large_slab.alloc();
+    is_large = true;
+  }
+  if (buf == NULL) return false;   // queue full
+
+  int i = 0;
+  while (_records[i].buf) i++;   // find unused record (always one, as num records == num slab buffers)
+
+  auto rec = &_records[i];
+  rec->buf = buf;
+  rec->len = packet->writeTo(buf);
+  rec->scheduled_for = scheduled_for;
+  rec->seq = _next_seq++;
+  rec->priority = priority;
+  rec->snr = packet->_snr;
+#if MESH_LATENCY_STATS
+  rec->lat_stamp = packet->_lat_stamp;
+#endif
+  rec->is_inbound = is_inbound;
+  rec->is_large = is_large;
+  if (is_inbound) {
+    _num_inbound++;
+  } else {
+    _num_outbound++;
+  }
+
+  free(packet);  // only the compact copy is kept while queued
+  return true;
+}
+
+void SlabPacketManager::decode(const QueuedRecord* rec, mesh::Packet* dest) {
+  const uint8_t* src = rec->buf;
+
+  // NOTE: the inverse of Packet::writeTo(), without the validation of Packet::readFrom() (was valid when queued)
+  int i = 0;
+  dest->header = src[i++];
+  if (dest->hasTransportCodes()) {
+    memcpy(&dest->transport_codes[0], &src[i], 2); i += 2;
+    memcpy(&dest->transport_codes[1], &src[i], 2); i += 2;
+  } else {
+    dest->transport_codes[0] = dest->transport_codes[1] = 0;
+  }
+  dest->path_len = src[i++];
+  i += mesh::Packet::writePath(dest->path, &src[i], dest->path_len);
+  dest->payload_len = rec->len - i;
+  memcpy(dest->payload, &src[i], dest->payload_len);
+  dest->_snr = rec->snr;
+  dest->invalidateHash();
+#if MESH_LATENCY_STATS
+  dest->_lat_stamp = rec->lat_stamp;
+#endif
+}
+
+void SlabPacketManager::release(int rec_idx) {
+  auto rec = &_records[rec_idx];
+  if (rec->is_large) {
+    large_slab.free(rec->buf);
+  } else {
+    small_slab.free(rec->buf);
+  }
+  rec->buf = NULL;
+  if (rec->is_inbound) {
+    _num_inbound--;
+  } else {
+    _num_outbound--;
+  }
+}
+
+mesh::Packet* SlabPacketManager::dequeue(int rec_idx) {
+  mesh::Packet* packet = pool.alloc();
+  if (packet) {
+    decode(&_records[rec_idx], packet);
+    release(rec_idx);
+  }
+  return packet;   // NULL if working set is exhausted (is left queued for now)
+}
+
+int SlabPacketManager::findNext(bool is_inbound, uint32_t now) const {
+  int best_idx = -1;
+  for (int i = 0; i < _num_records; i++) {
+    auto rec = &_records[i];
+    if (rec->buf == NULL || rec->is_inbound != is_inbound) continue;
+    if ((int32_t)(rec->scheduled_for - now) > 0) continue;   // scheduled for future... ignore for now
+
+    if (best_idx < 0) {
+      best_idx = i;
+    } else {
+      auto best = &_records[best_idx];
+      if (rec->priority < best->priority || (rec->priority == best->priority && (int32_t)(rec->seq - best->seq) < 0)) {
+        best_idx = i;
+      }
+    }
+  }
+  return best_idx;
+}
+
+int SlabPacketManager::findOutboundByIdx(int i) const {
+  for (int j = 0; j < _num_records; j++) {
+    if (_records[j].buf && !_records[j].is_inbound) {
+      if (i == 0) return j;
+      i--;
+    }
+  }
+  return -1;  // invalid index
+}
+
+bool SlabPacketManager::findNextDueTime(bool is_inbound, uint32_t& scheduled_for) const {
+  bool found = false;
+  for (int i = 0; i < _num_records; i++) {
+    auto rec = &_records[i];
+    if (rec->buf == NULL || rec->is_inbound != is_inbound) continue;
+
+    if (!found || (int32_t)(rec->scheduled_for - scheduled_for) < 0) {
+      scheduled_for = rec->scheduled_for;
+      found = true;
+    }
+  }
+  return found;
+}
+
+mesh::Packet* SlabPacketManager::allocNew() {
+  return pool.alloc();  // returns NULL if empty
+}
+
+void SlabPacketManager::free(mesh::Packet* packet) {
+  if (packet == &_peek) return;   // not from pool (see removeOutboundByIdx())
+  pool.free(packet);
+}
+
+void SlabPacketManager::queueOutbound(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for) {
+  if (!enqueue(packet, false, priority, scheduled_for)) {
+    MESH_DEBUG_PRINTLN("queueOutbound: send queue full, dropping packet");
+    free(packet);
+  }
+}
+
+mesh::Packet* SlabPacketManager::getNextOutbound(uint32_t now) {
+  int i = findNext(false, now);
+  return i < 0 ? NULL : dequeue(i);
+}
+
+int SlabPacketManager::getOutboundCount(uint32_t now) const {
+  if (now == 0xFFFFFFFF) return _num_outbound;  // sentinel: count all entries regardless of schedule
+
+  int n = 0;
+  for (int i = 0; i < _num_records; i++) {
+    auto rec = &_records[i];
+    if (rec->buf == NULL || rec->is_inbound) continue;
+    if ((int32_t)(rec->scheduled_for - now) > 0) continue;   // scheduled for future... ignore for now
+    n++;
+  }
+  return n;
+}
+
+int SlabPacketManager::getOutboundTotal() const {
+  return _num_outbound;
+}
+
+int SlabPacketManager::getFreeCount() const {
+  return pool.getFreeCount();
+}
+
+mesh::Packet* SlabPacketManager::getOutboundByIdx(int i) {
+  int j = findOutboundByIdx(i);
+  if (j < 0) return NULL;
+
+  decode(&_records[j], &_peek);
+  return &_peek;   // NOTE: only valid until next call
+}
+
+mesh::Packet* SlabPacketManager::removeOutboundByIdx(int i) {
+  int j = findOutboundByIdx(i);
+  if (j < 0) return NULL;
+
+  mesh::Packet* packet = pool.alloc();
+  if (packet == NULL) {
+    packet = &_peek;    // working set exhausted, free() will ignore this one
+  }
+  decode(&_records[j], packet);
+  release(j);
+  return packet;
+}
+
+void SlabPacketManager::queueInbound(mesh::Packet* packet, uint32_t scheduled_for) {
+  if (!enqueue(packet, true, 0, scheduled_for)) {
+    MESH_DEBUG_PRINTLN("queueInbound: rx queue full, dropping packet");
+    free(packet);
+  }
+}
+
+mesh::Packet* SlabPacketManager::getNextInbound(uint32_t now) {
+  int i = findNext(true, now);
+  return i < 0 ? NULL : dequeue(i);
+}
+
+bool SlabPacketManager::getPoolStats(mesh::PacketPoolStats& dest) const {
+  pool.getStats(dest);
+  return true;
+}
+
+void SlabPacketManager::resetPoolStats() {
+  pool.resetStats();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Dispatcher.h>
+#include "PacketPool.h"
+
+#ifndef SLAB_SMALL_SIZE
+  #define SLAB_SMALL_SIZE   64      // fits ACKs, PATH returns and short messages, with a moderate path
+#endif
+#define SLAB_LARGE_SIZE   MAX_TRANS_UNIT
+
+/**
+ * \brief  A fixed set of equal sized buffers, with an intrusive free-list.
+ */
+class PacketSlab {
+  uint8_t* _bufs;
+  uint8_t* _free_head;
+  int _num_free, _buf_size;
+
+public:
+  PacketSlab(int num_bufs, int buf_size);
+  uint8_t* alloc();
+  void free(uint8_t* buf);
+  int getBufSize() const { return _buf_size; }
+  int getFreeCount() const { return _num_free; }
+};
+
+/**
+ * \brief  A PacketManager which only keeps a small working set of full Packet instances. Packets sitting in the
+ *        inbound/outbound queues are held in their compact wire format, in 'small' or 'large' slab buffers, and are
+ *        restored into a working Packet when dequeued. Fits many more in-flight packets into the same RAM,
+ *        as most queued traffic (ACKs, PATH returns, short TXT_MSGs) is far smaller than a full Packet.
+ *        NOTE: a queued Packet comes back as a different instance than was queued.
+ */
+class SlabPacketManager : public mesh::PacketManager {
+  struct QueuedRecord {
+    uint8_t* buf;     // NULL if record is unused
+    uint32_t scheduled_for;
+    uint32_t seq;     // arrival order, so equal priorities are served FIFO
+    uint8_t len;
+    uint8_t priority;
+    int8_t snr;
+#if MESH_LATENCY_STATS
+    uint32_t lat_stamp;
+#endif
+    uint8_t is_inbound : 1;
+    uint8_t is_large : 1;
+  };
+  PacketPool pool;
+  PacketSlab small_slab, large_slab;
+  QueuedRecord* _records;
+  int _num_records;
+  int _num_outbound, _num_inbound;
+  uint32_t _next_seq;
+  mesh::Packet _peek;   // for getOutboundByIdx(), and removeOutboundByIdx() when working set is exhausted
+
+  bool enqueue(mesh::Packet* packet, bool is_inbound, uint8_t priority, uint32_t scheduled_for);
+  void decode(const QueuedRecord* rec, mesh::Packet* dest);
+  void release(int rec_idx);
+  mesh::Packet* dequeue(int rec_idx);
+  int findNext(bool is_inbound, uint32_t now) const;
+  int findOutboundByIdx(int i) const;
+  bool findNextDueTime(bool is_inbound, uint32_t& scheduled_for) const;
+
+public:
+  /**
+   * \param  num_working  number of full Packet instances (for Packets being created, received, or transmitted)
+   * \param  num_small    number of SLAB_SMALL_SIZE buffers for queued packets
+   * \param  num_large    number of MAX_TRANS_UNIT buffers for queued packets
+   */
+  SlabPacketManager(int num_working, int num_small, int num_large, mesh::MillisecondClock* ms=NULL);
+
+  mesh::Packet* allocNew() override;
+  void free(mesh::Packet* packet) override;
+  void queueOutbound(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for) override;
+  mesh::Packet* getNextOutbound(uint32_t now) override;
+  int getOutboundCount(uint32_t now) const override;
+  int getOutboundTotal() const override;
+  int getFreeCount() const override;
+  mesh::Packet* getOutboundByIdx(int i) override;
+  mesh::Packet* removeOutboundByIdx(int i) override;
+  void queueInbound(mesh::Packet* packet, uint32_t scheduled_for) override;
+  mesh::Packet* getNextInbound(uint32_t now) override;
+  bool getPoolStats(mesh::PacketPoolStats& dest) const override;
+  void resetPoolStats() override;
+  bool getNextOutboundTime(uint32_t now, uint32_t& scheduled_for) const override { return findNextDueTime(false, scheduled_for); }
+  bool getNextInboundTime(uint32_t now, uint32_t& scheduled_for) const override { return findNextDueTime(true, scheduled_for); }
+};
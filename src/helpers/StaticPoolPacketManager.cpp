@@ -19,6 +19,18 @@ int PacketQueue::countBefore(uint32_t now) const {
   return n;
 }
 
+bool PacketQueue::getNextDueTime(uint32_t& scheduled_for) const {
+  if (_num == 0) return false;
+
+  scheduled_for = _schedule_table[0];
+  for (int j = 1; j < _num; j++) {
+    if ((int32_t)(_schedule_table[j] - scheduled_for) < 0) {
+      scheduled_for = _schedule_table[j];
+    }
+  }
+  return true;
+}
+
 mesh::Packet* PacketQueue::get(uint32_t now) {
   uint8_t min_pri = 0xFF;
   int best_idx = -1;
@@ -68,19 +80,16 @@ bool PacketQueue::add(mesh::Packet* packet, uint8_t priority, uint32_t scheduled
   return true;
 }
 
-StaticPoolPacketManager::StaticPoolPacketManager(int pool_size): unused(pool_size), send_queue(pool_size), rx_queue(pool_size) {
-  // load up our unusued Packet pool
-  for (int i = 0; i < pool_size; i++) {
-    unused.add(new mesh::Packet(), 0, 0);
-  }
+StaticPoolPacketManager::StaticPoolPacketManager(int pool_size, mesh::MillisecondClock* ms)
+  : pool(pool_size, ms), send_queue(pool_size), rx_queue(pool_size) {
 }
 
 mesh::Packet* StaticPoolPacketManager::allocNew() {
-  return unused.removeByIdx(0);  // just get first one (returns NULL if empty)
+  return pool.alloc();  // returns NULL if empty
 }
 
 void StaticPoolPacketManager::free(mesh::Packet* packet) {
-  unused.add(packet, 0, 0);
+  pool.free(packet);
 }
 
 void StaticPoolPacketManager::queueOutbound(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for) {
@@ -104,7 +113,16 @@ int  StaticPoolPacketManager::getOutboundTotal() const {
 }
 
 int StaticPoolPacketManager::getFreeCount() const {
-  return unused.count();
+  return pool.getFreeCount();
+}
+
+bool StaticPoolPacketManager::getPoolStats(mesh::PacketPoolStats& dest) const {
+  pool.getStats(dest);
+  return true;
+}
+
+void StaticPoolPacketManager::resetPoolStats() {
+  pool.resetStats();
 }
 
 mesh::Packet* StaticPoolPacketManager::getOutboundByIdx(int i) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Dispatcher.h>
+#include "PacketPool.h"
 
 class PacketQueue {
   mesh::Packet** _table;
@@ -14,15 +15,17 @@ public:
   bool add(mesh::Packet* packet, uint8_t priority, uint32_t scheduled_for);
   int count() const { return _num; }
   int countBefore(uint32_t now) const;
+  bool getNextDueTime(uint32_t& scheduled_for) const;
   mesh::Packet* itemAt(int i) const { return _table[i]; }
   mesh::Packet* removeByIdx(int i);
 };
 
 class StaticPoolPacketManager : public mesh::PacketManager {
-  PacketQueue unused, send_queue, rx_queue;
+  PacketPool pool;
+  PacketQueue send_queue, rx_queue;
 
 public:
-  StaticPoolPacketManager(int pool_size);
+  StaticPoolPacketManager(int pool_size, mesh::MillisecondClock* ms=NULL);
 
   mesh::Packet* allocNew() override;
   void free(mesh::Packet* packet) override;
@@ -35,4 +38,8 @@ public:
   mesh::Packet* removeOutboundByIdx(int i) override;
   void queueInbound(mesh::Packet* packet, uint32_t scheduled_for) override;
   mesh::Packet* getNextInbound(uint32_t now) override;
+  bool getPoolStats(mesh::PacketPoolStats& dest) const override;
+  void resetPoolStats() override;
+  bool getNextOutboundTime(uint32_t now, uint32_t& scheduled_for) const override { return send_queue.getNextDueTime(scheduled_for); }
+  bool getNextInboundTime(uint32_t now, uint32_t& scheduled_for) const override { return rx_queue.getNextDueTime(scheduled_for); }
 };
\ No newline at end of file
@@ -18,6 +18,17 @@ public:
     );
   }
 
+  // appends the shared secret cache [hits, misses]
+  static void formatCoreStats(char* reply,
+                             mesh::MainBoard& board,
+                             mesh::MillisecondClock& ms,
+                             uint16_t err_flags,
+                             mesh::PacketManager* mgr,
+                             const mesh::SharedSecretCache& secrets) {
+    formatCoreStats(reply, board, ms, err_flags, mgr);
+    sprintf(strchr(reply, 0) - 1, ",\"ecdh_cache\":[%u,%u]}", secrets.getNumHits(), secrets.getNumMisses());
+  }
+
   template<typename RadioDriverType>
   static void formatRadioStats(char* reply,
                               mesh::Radio* radio,
@@ -34,6 +45,24 @@ public:
     );
   }
 
+  // appends the channel utilisation (percent) over a short and long window, and the sends forced on a busy channel
+  template<typename RadioDriverType>
+  static void formatRadioStats(char* reply,
+                              mesh::Radio* radio,
+                              RadioDriverType& driver,
+                              uint32_t total_air_time_ms,
+                              uint32_t total_rx_air_time_ms,
+                              uint16_t chan_util_short_permille,
+                              uint16_t chan_util_long_permille,
+                              uint32_t n_forced_sends) {
+    formatRadioStats(reply, radio, driver, total_air_time_ms, total_rx_air_time_ms);
+    sprintf(strchr(reply, 0) - 1, ",\"chan_util\":[%u,%u],\"forced_tx\":%u}",
+      (uint32_t) (chan_util_short_permille + 5) / 10,
+      (uint32_t) (chan_util_long_permille + 5) / 10,
+      n_forced_sends
+    );
+  }
+
   template<typename RadioDriverType>
   static void formatPacketStats(char* reply,
                                RadioDriverType& driver,
@@ -52,4 +81,147 @@ public:
       driver.getPacketsRecvErrors()
     );
   }
+
+  template<typename RadioDriverType>
+  static void formatPacketStats(char* reply,
+                               RadioDriverType& driver,
+                               uint32_t n_sent_flood,
+                               uint32_t n_sent_direct,
+                               uint32_t n_recv_flood,
+                               uint32_t n_recv_direct,
+                               mesh::PacketManager* mgr) {
+    formatPacketStats(reply, driver, n_sent_flood, n_sent_direct, n_recv_flood, n_recv_direct);
+
+    mesh::PacketPoolStats pool;
+    if (mgr->getPoolStats(pool)) {   // append the pool occupancy, inside the closing brace
+      sprintf(strchr(reply, 0) - 1,
+        ",\"pool_free\":%u,\"pool_peak\":%u,\"pool_fails\":%u,\"pool_empty_secs\":%u}",
+        (uint32_t) pool.num_free,
+        (uint32_t) pool.max_in_use,
+        pool.n_alloc_fails,
+        pool.empty_millis / 1000
+      );
+      if (pool.n_bad_frees > 0) {   // a bug, so only shown when it has happened
+        sprintf(strchr(reply, 0) - 1, ",\"pool_bad_frees\":%u}", pool.n_bad_frees);
+      }
+    }
+  }
+
+  // per TX_CLASS_*: [sent, avg wait millis, max wait millis, num starved]
+  static void formatTxClassStats(char* reply, mesh::PacketManager* mgr) {
+    static const char* names[NUM_TX_CLASSES] = { "ack", "direct", "flood", "bulk" };
+
+    char* dp = reply;
+    *dp++ = '{';
+    for (int c = 0; c < NUM_TX_CLASSES; c++) {
+      mesh::TxClassStats s;
+      if (!mgr->getTxClassStats(c, s)) {
+        strcpy(reply, "Not supported");
+        return;
+      }
+      dp += sprintf(dp, "%s\"%s\":[%u,%u,%u,%u]", c > 0 ? "," : "", names[c],
+        s.n_sent,
+        s.n_sent > 0 ? s.total_wait_millis / s.n_sent : 0,
+        s.max_wait_millis,
+        s.n_starved
+      );
+    }
+    strcpy(dp, "}");
+  }
+
+  static void formatTxClassStats(char* reply, mesh::PacketManager* mgr, uint32_t n_flood_suppressed, uint32_t flood_suppressed_millis) {
+    formatTxClassStats(reply, mgr);
+
+    // [cancelled rebroadcasts, est. airtime saved (secs)], inside the closing brace (if any)
+    char* dp = reply[0] == '{' ? strchr(reply, 0) - 1 : reply;
+    sprintf(dp, "%s\"flood_suppressed\":[%u,%u]}", dp == reply ? "{" : ",", n_flood_suppressed, flood_suppressed_millis / 1000);
+  }
+
+  // wait (millis, from receive until checked) and verify (micros) are [avg, max]
+  static void formatAdvertVerifyStats(char* reply, const mesh::AdvertVerifyStats& s) {
+    uint32_t n_checked = s.n_verified + s.n_forged;
+    sprintf(reply,
+      "{\"depth\":%u,\"max_depth\":%u,\"verified\":%u,\"forged\":%u,\"overflow\":%u,\"wait_ms\":[%u,%u],\"verify_us\":[%u,%u]}",
+      (uint32_t) s.depth,
+      (uint32_t) s.max_depth,
+      s.n_verified,
+      s.n_forged,
+      s.n_overflow,
+      s.n_deferred > 0 ? s.total_wait_millis / s.n_deferred : 0,
+      s.max_wait_millis,
+      n_checked > 0 ? s.total_verify_micros / n_checked : 0,
+      s.max_verify_micros
+    );
+  }
+
+#if MESH_LATENCY_STATS
+  // approx. percentile, as the upper bound of the bucket it falls in
+  static uint32_t getLatencyPercentile(const mesh::LatencyHistogram* h, uint32_t n, int pct) {
+    uint32_t target = (n * pct + 99) / 100, sum = 0;
+    for (int b = 0; b < LAT_NUM_BUCKETS; b++) {
+      sum += h->counts[b];
+      if (sum >= target) return b == 0 ? 0 : (1UL << b) - 1;
+    }
+    return (1UL << (LAT_NUM_BUCKETS - 1)) - 1;
+  }
+
+  // with no 'stage': per LAT_STAGE_*: [count, mean]
+  // else, for each payload type/route type seen in that stage: [count, mean, ~p50, ~p99]
+  static void formatLatencyStats(char* reply, const mesh::LatencyHistograms& lat, const char* stage) {
+    static const char* names[NUM_LAT_STAGES] = { "parse", "rx_delay", "process", "crypto", "tx_delay", "tx_queue", "cad", "airtime" };
+    static const char* routes[4] = { "TF", "F", "D", "TD" };   // by ROUTE_TYPE_*
+    const int max_len = 200;   // must fit in the serial CLI reply
+
+    int s = -1;
+    for (int i = 0; i < NUM_LAT_STAGES && *stage; i++) {
+      if (strcmp(stage, names[i]) == 0) s = i;
+    }
+    if (*stage && s < 0) {
+      strcpy(reply, "Error: unknown stage");
+      return;
+    }
+
+    char* dp = reply;
+    if (s < 0) {
+      *dp++ = '{';
+      for (int i = 0; i < NUM_LAT_STAGES; i++) {
+        uint32_t n = 0, total = 0;
+        for (int j = 0; j < lat.getCount(); j++) {
+          auto h = lat.getByIdx(j);
+          if (h->stage != i) continue;
+          for (int b = 0; b < LAT_NUM_BUCKETS; b++) n += h->counts[b];
+          total += h->total;
+        }
+        if ((dp - reply) + 36 > max_len) break;   // no room (only on extreme counts)
+        dp += sprintf(dp, "%s\"%s\":[%u,%u]", i > 0 ? "," : "", names[i], n, n > 0 ? total / n : 0);
+      }
+      if (lat.getNumDropped() > 0 && (dp - reply) + 24 <= max_len) dp += sprintf(dp, ",\"dropped\":%u", lat.getNumDropped());
+      strcpy(dp, "}");
+      return;
+    }
+
+    bool is_micros = s == LAT_STAGE_RX_PARSE || s == LAT_STAGE_RX_PROCESS || s == LAT_STAGE_RX_CRYPTO;
+    dp += sprintf(dp, "{\"unit\":\"%s\"", is_micros ? "us" : "ms");
+    int n_more = 0;
+    for (int j = 0; j < lat.getCount(); j++) {
+      auto h = lat.getByIdx(j);
+      if (h->stage != s) continue;
+
+      uint32_t n = 0;
+      for (int b = 0; b < LAT_NUM_BUCKETS; b++) n += h->counts[b];
+
+      char tmp[48];
+      int len = sprintf(tmp, ",\"%X%s\":[%u,%u,%u,%u]", h->key >> PH_TYPE_SHIFT, routes[h->key & PH_ROUTE_MASK],
+        n, h->total / n, getLatencyPercentile(h, n, 50), getLatencyPercentile(h, n, 99));
+      if ((dp - reply) + len > max_len - 16) {
+        n_more++;   // no room
+      } else {
+        strcpy(dp, tmp);
+        dp += len;
+      }
+    }
+    if (n_more > 0) dp += sprintf(dp, ",\"more\":%d", n_more);
+    strcpy(dp, "}");
+  }
+#endif
 };
@@ -90,3 +90,29 @@ bool TransportKeyStore::clear() {
 
   return false;  // failed
 }
+
+#define SAVED_CACHE_ENTRY_SIZE  (2 + (int)sizeof(TransportKey))
+
+int TransportKeyStore::saveCacheTo(uint8_t* dest, int max_len) const {
+  int len = 0;
+  for (int i = 0; i < num_cache && len + SAVED_CACHE_ENTRY_SIZE <= max_len; i++) {
+    memcpy(&dest[len], &cache_ids[i], 2); len += 2;
+    memcpy(&dest[len], cache_keys[i].key, sizeof(cache_keys[i].key)); len += sizeof(cache_keys[i].key);
+  }
+  return len;
+}
+
+void TransportKeyStore::restoreCacheFrom(const uint8_t* src, int len) {
+  for (int i = 0; i + SAVED_CACHE_ENTRY_SIZE <= len; i += SAVED_CACHE_ENTRY_SIZE) {
+    uint16_t id;
+    TransportKey key;
+    memcpy(&id, &src[i], 2);
+    memcpy(key.key, &src[i + 2], sizeof(key.key));
+
+    bool cached = false;
+    for (int j = 0; j < num_cache && !cached; j++) {
+      cached = cache_ids[j] == id && memcmp(cache_keys[j].key, key.key, sizeof(key.key)) == 0;
+    }
+    if (!cached) putCache(id, key);
+  }
+}
@@ -28,4 +28,8 @@ public:
   bool saveKeysFor(uint16_t id, const TransportKey keys[], int num);
   bool removeKeys(uint16_t id);
   bool clear();
+
+  // for WarmState: the cache of derived keys
+  int saveCacheTo(uint8_t* dest, int max_len) const;
+  void restoreCacheFrom(const uint8_t* src, int len);
 };
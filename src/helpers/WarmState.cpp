@@ -0,0 +1,187 @@
+#include "WarmState.h"
+#include <Utils.h>
+
+#define WARM_STATE_MAGIC     0x4D524157   // "WARM"
+#define WARM_STATE_VERSION   1
+
+#define SECTION_HDR_SIZE     3   // id, len (2)
+
+static File openWrite(FILESYSTEM* _fs, const char* filename) {
+  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+    _fs->remove(filename);
+    return _fs->open(filename, FILE_O_WRITE);
+  #elif defined(RP2040_PLATFORM)
+    return _fs->open(filename, "w");
+  #else
+    return _fs->open(filename, "w", true);
+  #endif
+}
+
+WarmState::WarmState(uint8_t* retained_buf, int size) {
+  _buf = retained_buf;
+  _size = size;
+  _len = 0;    // NOTE: must not touch _buf contents here, is the retained copy
+  _section = -1;
+  _elapsed = 0;
+  _loaded = false;
+  _owned = false;
+}
+
+WarmState::WarmState(int size) {
+  _buf = NULL;
+  _size = size;
+  _len = 0;
+  _section = -1;
+  _elapsed = 0;
+  _loaded = false;
+  _owned = true;
+}
+
+bool WarmState::allocBuf() {
+  if (_buf == NULL && _owned) {
+    _buf = new uint8_t[_size];
+    if (_buf) invalidate();
+  }
+  return _buf != NULL;
+}
+
+void WarmState::release() {
+  _loaded = false;
+  if (_owned) {
+    delete[] _buf;
+    _buf = NULL;
+  }
+}
+
+uint32_t WarmState::calcCheck() const {
+  static const uint8_t key[16] = { 0 };   // just detecting garbage (eg. RAM after power loss), not tampering
+  return (uint32_t) mesh::Utils::sipHash(key, &_buf[sizeof(uint32_t)], sizeof(Header) - sizeof(uint32_t) + header()->len);
+}
+
+bool WarmState::isValid() const {
+  if (_buf == NULL || _size < (int)sizeof(Header)) return false;
+
+  auto h = header();
+  return h->magic == WARM_STATE_MAGIC && h->version == WARM_STATE_VERSION
+      && h->len <= _size - (int)sizeof(Header) && h->check == calcCheck();
+}
+
+void WarmState::invalidate() {
+  if (_buf && _size >= (int)sizeof(Header)) header()->magic = 0;
+}
+
+void WarmState::beginSave() {
+  _section = -1;
+  if (!allocBuf()) {
+    _len = 0;   // beginSection() will fail
+    return;
+  }
+  invalidate();   // in case we're reset part way through
+  _len = sizeof(Header);
+  _section = -1;
+}
+
+uint8_t* WarmState::beginSection(uint8_t id, int& max_len) {
+  max_len = _size - _len - SECTION_HDR_SIZE;
+  if (_len == 0 || max_len <= 0) return NULL;
+
+  _section = _len;
+  _buf[_len] = id;
+  return &_buf[_len + SECTION_HDR_SIZE];
+}
+
+void WarmState::endSection(int len) {
+  if (_section < 0) return;
+
+  if (len > 0) {   // empty sections are omitted
+    uint16_t n = len;
+    memcpy(&_buf[_section + 1], &n, 2);
+    _len += SECTION_HDR_SIZE + len;
+  }
+  _section = -1;
+}
+
+void WarmState::endSave(uint32_t now_secs) {
+  if (_len == 0) return;   // beginSave() not called
+
+  auto h = header();
+  h->len = _len - sizeof(Header);
+  h->version = WARM_STATE_VERSION;
+  h->reserved = 0;
+  h->saved_at = now_secs;
+  h->magic = WARM_STATE_MAGIC;
+  h->check = calcCheck();
+  _len = 0;
+}
+
+bool WarmState::saveFile(FILESYSTEM* fs) const {
+  if (!isValid()) return false;
+
+  File file = openWrite(fs, WARM_STATE_FILE);
+  if (!file) return false;
+
+  int len = sizeof(Header) + header()->len;
+  bool success = (file.write(_buf, len) == (size_t)len);
+  file.close();
+  return success;
+}
+
+bool WarmState::load(FILESYSTEM* fs, mesh::RTCClock* rtc) {
+  _loaded = false;
+  bool from_ram = isValid();
+  if (fs && fs->exists(WARM_STATE_FILE)) {
+    if (!from_ram && allocBuf()) {
+    #if defined(RP2040_PLATFORM)
+      File file = fs->open(WARM_STATE_FILE, "r");
+    #else
+      File file = fs->open(WARM_STATE_FILE);
+    #endif
+      if (file) {
+        file.read(_buf, _size);
+        file.close();
+      }
+    }
+    fs->remove(WARM_STATE_FILE);   // only ever used once, so a stale record can't come back after a later power loss
+  }
+  if (!from_ram && !isValid()) {
+    invalidate();   // may be garbage (eg. from power loss), or partial file
+    release();
+    return false;
+  }
+
+  uint32_t now = rtc->getCurrentTime();
+  uint32_t saved_at = header()->saved_at;
+  if (now >= saved_at) {
+    _elapsed = now - saved_at;
+  } else if (from_ram) {
+    MESH_DEBUG_PRINTLN("WarmState: clock was reset, restoring to: %u", saved_at);
+    rtc->setCurrentTime(saved_at);
+    _elapsed = 0;
+  } else {
+    MESH_DEBUG_PRINTLN("WarmState: clock is behind flash record, ignoring it");
+    invalidate();
+    release();
+    return false;
+  }
+  _loaded = true;
+  return true;
+}
+
+const uint8_t* WarmState::findSection(uint8_t id, int& len) const {
+  if (!_loaded) return NULL;
+
+  int end = sizeof(Header) + header()->len;
+  int i = sizeof(Header);
+  while (i + SECTION_HDR_SIZE <= end) {
+    uint16_t n;
+    memcpy(&n, &_buf[i + 1], 2);
+    if (i + SECTION_HDR_SIZE + n > end) break;   // malformed
+
+    if (_buf[i] == id) {
+      len = n;
+      return &_buf[i + SECTION_HDR_SIZE];
+    }
+    i += SECTION_HDR_SIZE + n;
+  }
+  return NULL;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Arduino.h>   // needed for PlatformIO
+#include <Mesh.h>
+#include <helpers/IdentityStore.h>
+
+#ifndef WARM_STATE_SIZE
+  #if defined(ESP32)
+    #define WARM_STATE_SIZE   4096    // RTC memory is only 8K
+  #else
+    #define WARM_STATE_SIZE   6144
+  #endif
+#endif
+#ifndef WARM_STATE_SYNC_SECS
+  #define WARM_STATE_SYNC_SECS   10   // how often the retained copy is refreshed
+#endif
+
+// RAM which is NOT cleared by a soft reset (reboot, watchdog, crash) or deep sleep, for the retained copy
+#if defined(ESP32)
+  #include <esp_attr.h>
+  #define WARM_STATE_ATTR   RTC_NOINIT_ATTR
+  #define WARM_STATE_RETAINED   1
+#elif defined(NRF52_PLATFORM)
+  #define WARM_STATE_ATTR   __attribute__((section(".noinit")))
+  #define WARM_STATE_RETAINED   1
+#elif defined(RP2040_PLATFORM)
+  #define WARM_STATE_ATTR   __attribute__((section(".uninitialized_data")))
+  #define WARM_STATE_RETAINED   1
+#else
+  #define WARM_STATE_ATTR       // not retained, so only the flash record can be restored
+  #define WARM_STATE_RETAINED   0
+#endif
+
+#define WARM_STATE_FILE   "/warm"
+
+#define WARM_SECTION_TABLES          1
+#define WARM_SECTION_DEDUPE_KEY      2
+#define WARM_SECTION_TRANSPORT_KEYS  3
+#define WARM_SECTION_NEIGHBOURS      4
+
+/**
+ * \brief  A snapshot of transient state (eg. seen packet hashes, neighbours) which lets a node carry on where it left off
+ *        after a reboot or deep sleep, instead of re-forwarding every packet it hears again. The snapshot is a list of
+ *        tagged sections, in a buffer the app places in retained RAM (see WARM_STATE_ATTR), and is refreshed
+ *        periodically. Before a planned reboot or power off, it is also written to flash, for boards/resets which
+ *        don't retain RAM. A snapshot is only used if its checksum and RTC timestamp are valid.
+ *        Where RAM isn't retained (WARM_STATE_RETAINED is 0), the buffer is only allocated while a snapshot is being
+ *        written to, or restored from, flash.
+ */
+class WarmState {
+  struct Header {
+    uint32_t check;       // of everything after this field
+    uint32_t magic;
+    uint16_t len;         // of sections which follow
+    uint8_t  version;
+    uint8_t  reserved;
+    uint32_t saved_at;    // RTC secs
+  };
+  uint8_t* _buf;
+  int _size, _len;
+  int _section;           // offset of section being built, or -1
+  uint32_t _elapsed;
+  bool _loaded;
+  bool _owned;            // _buf is allocated on demand, not retained
+
+  Header* header() const { return (Header *) _buf; }
+  uint32_t calcCheck() const;
+  bool isValid() const;
+  bool allocBuf();
+
+public:
+  WarmState(uint8_t* retained_buf, int size);
+  WarmState(int size);   // no retained RAM
+
+  // building a snapshot
+  void beginSave();
+  uint8_t* beginSection(uint8_t id, int& max_len);   // returns NULL if no room left
+  void endSection(int len);
+  void endSave(uint32_t now_secs);
+  bool saveFile(FILESYSTEM* fs) const;
+  void invalidate();
+
+  /**
+   * \brief  finds the last snapshot, in retained RAM, otherwise in flash. The flash record is then removed.
+   *        If the RTC went backwards (eg. was reset with the CPU), a RAM snapshot is still trusted, as RAM
+   *        can't have survived a long power loss, and the clock is wound forward to the snapshot's time.
+   * \returns  false if there is no usable snapshot
+   */
+  bool load(FILESYSTEM* fs, mesh::RTCClock* rtc);
+
+  void release();   // done with the snapshot, frees the buffer if not retained
+  bool isRetained() const { return !_owned; }
+
+  bool isLoaded() const { return _loaded; }
+  uint32_t getElapsedSecs() const { return _elapsed; }   // since snapshot was taken
+  const uint8_t* findSection(uint8_t id, int& len) const;
+};
@@ -93,6 +93,11 @@ void RadioLibWrapper::loop() {
   }
 }
 
+bool RadioLibWrapper::needsPolling() const {
+  if (state != STATE_RX && state != STATE_TX_WAIT) return true;   // interrupt pending, or need to (re)start receive
+  return _num_floor_samples < NUM_NOISE_FLOOR_SAMPLES || _floor_sample_sum != 0;   // noise floor sampling in progress
+}
+
 void RadioLibWrapper::startRecv() {
   int err = _radio->startReceive();
   if (err == RADIOLIB_ERR_NONE) {
@@ -181,23 +186,29 @@ float RadioLibWrapper::getLastSNR() const {
   return _radio->getSNR();
 }
 
-// Approximate SNR threshold per SF for successful reception (based on Semtech datasheets)
-static float snr_threshold[] = {
-    -7.5,  // SF7 needs at least -7.5 dB SNR
-    -10,   // SF8 needs at least -10 dB SNR
-    -12.5, // SF9 needs at least -12.5 dB SNR
-    -15,  // SF10 needs at least -15 dB SNR
-    -17.5,// SF11 needs at least -17.5 dB SNR
-    -20   // SF12 needs at least -20 dB SNR
+// Approximate SNR threshold per SF for successful reception (based on Semtech datasheets), in quarter dB
+static const int16_t snr_threshold_x4[] = {
+    -30,  // SF7 needs at least -7.5 dB SNR
+    -40,  // SF8 needs at least -10 dB SNR
+    -50,  // SF9 needs at least -12.5 dB SNR
+    -60,  // SF10 needs at least -15 dB SNR
+    -70,  // SF11 needs at least -17.5 dB SNR
+    -80   // SF12 needs at least -20 dB SNR
 };
-  
+
 float RadioLibWrapper::packetScoreInt(float snr, int sf, int packet_len) {
   if (sf < 7) return 0.0f;
-  
-  if (snr < snr_threshold[sf - 7]) return 0.0f;    // Below threshold, no chance of success
+  if (sf > 12) sf = 12;
+
+  // NOTE: integer math (16.16), as this is per packet, and many MCUs have no FPU
+  int32_t margin = (int32_t)(snr * 256.0f) - snr_threshold_x4[sf - 7] * 64;    // in 1/256 dB
+  if (margin < 0) return 0.0f;    // Below threshold, no chance of success
 
-  auto success_rate_based_on_snr = (snr - snr_threshold[sf - 7]) / 10.0;
-  auto collision_penalty = 1 - (packet_len / 256.0);   // Assuming max packet of 256 bytes
+  int64_t success_rate_based_on_snr = (int64_t)margin * 65536 / 2560;   // 10 dB above threshold = 1.0
+  int64_t collision_penalty = 65536 - packet_len * 256;   // Assuming max packet of 256 bytes
 
-  return max(0.0, min(1.0, success_rate_based_on_snr * collision_penalty));
+  int64_t score = (success_rate_based_on_snr * collision_penalty) >> 16;
+  if (score < 0) score = 0;
+  if (score > 65536) score = 65536;
+  return (float)score * (1.0f / 65536.0f);
 }
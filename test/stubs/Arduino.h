@@ -0,0 +1,26 @@
+#pragma once
+
+// Minimal Arduino API for the native (host) unit tests
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <Stream.h>
+#include <FS.h>
+
+using std::min;
+using std::max;
+
+inline Stream Serial;
+
+inline unsigned long millis() { return 0; }   // NOTE: tests use their own mesh::MillisecondClock
+
+inline char* ltoa(long value, char* dest, int base) {   // NOTE: base 10 only
+  sprintf(dest, "%ld", value);
+  return dest;
+}
+
+inline void* ps_calloc(size_t n, size_t size) { return calloc(n, size); }   // no PSRAM, just the heap
@@ -0,0 +1,88 @@
+#pragma once
+
+// In-memory file system for the native (host) unit tests, with the ESP32 fs::FS API.
+// MemFlash::budget simulates a power loss: once that many 'steps' (bytes written, file
+// creates/truncates, removes) have been done, every further write fails.
+
+#include <Stream.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+struct MemFlash {
+  static inline std::map<std::string, std::vector<uint8_t>> files;
+  static inline long budget = -1;   // -1 = no power loss
+  static inline long steps = 0;
+
+  static bool step() {
+    steps++;
+    if (budget == 0) return false;
+    if (budget > 0) budget--;
+    return true;
+  }
+  static void reset() {
+    files.clear();
+    budget = -1;
+    steps = 0;
+  }
+};
+
+class File : public Stream {
+  std::string _name;
+  size_t _pos;
+  bool _open;
+
+public:
+  File() : _pos(0), _open(false) { }
+  File(const char* name) : _name(name), _pos(0), _open(true) { }
+
+  operator bool() const { return _open; }
+  const char* name() const { return _name.c_str(); }
+  size_t size() const { return _open ? MemFlash::files[_name].size() : 0; }
+  void close() { _open = false; }
+
+  int available() override { return _open ? (int)(size() - _pos) : 0; }
+  int read() override {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  size_t read(uint8_t* buf, size_t len) override {
+    if (!_open) return 0;
+    auto& data = MemFlash::files[_name];
+    size_t n = 0;
+    while (n < len && _pos < data.size()) buf[n++] = data[_pos++];
+    return n;
+  }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t len) override {   // NOTE: always appends
+    if (!_open) return 0;
+    auto& data = MemFlash::files[_name];
+    size_t n = 0;
+    while (n < len && MemFlash::step()) data.push_back(buf[n++]);
+    return n;
+  }
+};
+
+class FS {
+public:
+  File open(const char* path, const char* mode="r", bool create=false) {
+    bool exists = MemFlash::files.count(path) > 0;
+    if (mode[0] == 'r') {
+      return exists ? File(path) : File();
+    }
+    if (mode[0] == 'w' || !exists) {   // truncate, or create
+      if (!MemFlash::step()) return File();
+      MemFlash::files[path].clear();
+    }
+    return File(path);
+  }
+  bool exists(const char* path) { return MemFlash::files.count(path) > 0; }
+  bool remove(const char* path) { return MemFlash::step() && MemFlash::files.erase(path) > 0; }
+  bool mkdir(const char* path) { return true; }
+};
+
+}
+
+using fs::File;
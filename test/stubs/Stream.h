@@ -0,0 +1,35 @@
+#pragma once
+
+// Minimal Print/Stream for the native (host) unit tests, output goes to stdout
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+class Print {
+public:
+  virtual ~Print() { }
+  virtual size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+  virtual size_t write(const uint8_t* buf, size_t len) { return fwrite(buf, 1, len, stdout); }
+  size_t print(const char* s) { return write((const uint8_t *) s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t) c); }
+  size_t print(int n) { return printf("%d", n); }
+  size_t println(const char* s="") { return print(s) + print('\n'); }
+  size_t printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n < 0 ? 0 : n;
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual size_t read(uint8_t* buf, size_t len) { return 0; }
+  size_t readBytes(uint8_t* buf, size_t len) { return read(buf, len); }
+};
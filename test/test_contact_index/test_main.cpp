@@ -0,0 +1,189 @@
+#include <unity.h>
+#include <helpers/BaseChatMesh.h>
+#include <helpers/StaticPoolPacketManager.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+// BaseChatMesh key index (key_order[]) vs a brute force scan of the contacts, incl. keys which share
+// a CONTACT_KEY_PREFIX_SIZE prefix. Then prints the lookup time with a cold CPU cache.
+
+using namespace mesh;
+
+struct NullClock : public MillisecondClock {
+  unsigned long getMillis() override { return 0; }
+};
+
+struct NullRadio : public Radio {
+  int recvRaw(uint8_t* bytes, int sz) override { return 0; }
+  uint32_t getEstAirtimeFor(int len_bytes) override { return 0; }
+  float packetScore(float snr, int packet_len) override { return 0; }
+  bool startSendRaw(const uint8_t* bytes, int len) override { return false; }
+  bool isSendComplete() override { return false; }
+  void onSendFinished() override { }
+  bool isInRecvMode() const override { return true; }
+};
+
+struct FixedRTC : public RTCClock {
+  uint32_t getCurrentTime() override { return 1700000000; }
+  void setCurrentTime(uint32_t time) override { }
+};
+
+struct StdRNG : public RNG {
+  void random(uint8_t* dest, size_t sz) override {
+    for (size_t i = 0; i < sz; i++) dest[i] = rand();
+  }
+};
+
+struct NullTables : public MeshTables {
+  bool hasSeen(const Packet* packet) override { return false; }
+  void clear(const Packet* packet) override { }
+};
+
+class TestMesh : public BaseChatMesh {
+protected:
+  void onDiscoveredContact(ContactInfo& contact, bool is_new, uint8_t path_len, const uint8_t* path) override { }
+  ContactInfo* processAck(const uint8_t *data) override { return NULL; }
+  void onContactPathUpdated(const ContactInfo& contact) override { }
+  void onMessageRecv(const ContactInfo& contact, Packet* pkt, uint32_t sender_timestamp, const char *text) override { }
+  void onCommandDataRecv(const ContactInfo& contact, Packet* pkt, uint32_t sender_timestamp, const char *text) override { }
+  void onSignedMessageRecv(const ContactInfo& contact, Packet* pkt, uint32_t sender_timestamp, const uint8_t *sender_prefix, const char *text) override { }
+  uint32_t calcFloodTimeoutMillisFor(uint32_t pkt_airtime_millis) const override { return 0; }
+  uint32_t calcDirectTimeoutMillisFor(uint32_t pkt_airtime_millis, uint8_t path_len) const override { return 0; }
+  void onSendTimeout() override { }
+  void onChannelMessageRecv(const GroupChannel& channel, Packet* pkt, uint32_t timestamp, const char *text) override { }
+  uint8_t onContactRequest(const ContactInfo& contact, uint32_t sender_timestamp, const uint8_t* data, uint8_t len, uint8_t* reply) override { return 0; }
+  void onContactResponse(const ContactInfo& contact, const uint8_t* data, uint8_t len) override { }
+
+public:
+  TestMesh(Radio& radio, MillisecondClock& ms, RNG& rng, RTCClock& rtc, PacketManager& mgr, MeshTables& tables)
+    : BaseChatMesh(radio, ms, rng, rtc, mgr, tables) { }
+
+  using BaseChatMesh::addContact;
+  using BaseChatMesh::removeContact;
+  using BaseChatMesh::lookupContactByPubKey;
+  using BaseChatMesh::searchPeersByHash;
+};
+
+static NullRadio radio;
+static NullClock ms;
+static StdRNG rng;
+static FixedRTC rtc;
+static StaticPoolPacketManager mgr(4);
+static NullTables tables;
+
+// every 4th key repeats the previous key's first 8 bytes, and the first byte (the hash) is one of 16
+static void makeKeys(std::vector<ContactInfo>& keys, int n) {
+  keys.resize(n);
+  for (int i = 0; i < n; i++) {
+    ContactInfo& c = keys[i];
+    memset(&c, 0, sizeof(c));
+    rng.random(c.id.pub_key, PUB_KEY_SIZE);
+    c.id.pub_key[0] &= 0x0F;
+    if (i % 4 == 3) memcpy(c.id.pub_key, keys[i - 1].id.pub_key, 8);
+    snprintf(c.name, sizeof(c.name), "c%d", i);
+    c.lastmod = i;
+  }
+}
+
+static int countByScan(const std::vector<ContactInfo>& keys, const std::vector<bool>& present, const uint8_t* key, int len) {
+  int n = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (present[i] && memcmp(keys[i].id.pub_key, key, len) == 0) n++;
+  }
+  return n;
+}
+
+static void checkIndex(TestMesh& mesh, const std::vector<ContactInfo>& keys, const std::vector<bool>& present) {
+  for (size_t i = 0; i < keys.size(); i++) {
+    ContactInfo* c = mesh.lookupContactByPubKey(keys[i].id.pub_key, PUB_KEY_SIZE);
+    if (present[i]) {
+      TEST_ASSERT_NOT_NULL(c);
+      TEST_ASSERT_EQUAL_STRING(keys[i].name, c->name);
+    } else {
+      TEST_ASSERT_NULL(c);
+    }
+    c = mesh.lookupContactByPubKey(keys[i].id.pub_key, 9);   // just past the index prefix
+    TEST_ASSERT_EQUAL(countByScan(keys, present, keys[i].id.pub_key, 9) > 0, c != NULL);
+
+    int expected = countByScan(keys, present, keys[i].id.pub_key, PATH_HASH_SIZE);
+    TEST_ASSERT_EQUAL(std::min(expected, MAX_SEARCH_RESULTS), mesh.searchPeersByHash(keys[i].id.pub_key));
+  }
+}
+
+void setUp() { }
+void tearDown() { }
+
+void test_lookup_matches_scan() {
+  TestMesh mesh(radio, ms, rng, rtc, mgr, tables);
+  std::vector<ContactInfo> keys;
+  srand(1);
+  makeKeys(keys, MAX_CONTACTS);
+
+  std::vector<bool> present(keys.size(), false);
+  for (size_t i = 0; i < keys.size(); i++) {
+    TEST_ASSERT_TRUE(mesh.addContact(keys[i]));
+    present[i] = true;
+  }
+  TEST_ASSERT_EQUAL(MAX_CONTACTS, mesh.getNumContacts());
+  checkIndex(mesh, keys, present);
+
+  for (size_t i = 0; i < keys.size(); i += 3) {   // contacts after each one removed move down in contacts[]
+    TEST_ASSERT_TRUE(mesh.removeContact(keys[i]));
+    present[i] = false;
+  }
+  checkIndex(mesh, keys, present);
+
+  for (size_t i = 0; i < keys.size(); i += 6) {
+    TEST_ASSERT_TRUE(mesh.addContact(keys[i]));
+    present[i] = true;
+  }
+  checkIndex(mesh, keys, present);
+}
+
+static std::vector<uint8_t> evict(256 * 1024 * 1024);   // bigger than the L3 cache
+
+static void flushCache() {
+  for (size_t i = 0; i < evict.size(); i += 64) evict[i]++;
+}
+
+void test_cold_lookup_time() {
+  TestMesh mesh(radio, ms, rng, rtc, mgr, tables);
+  std::vector<ContactInfo> keys;
+  srand(2);
+  makeKeys(keys, MAX_CONTACTS);
+  for (auto& c : keys) mesh.addContact(c);
+
+  const int N = 20;
+  double lookup_ns = 0, search_ns = 0;
+  for (int i = 0; i < N; i++) {
+    const uint8_t* key = keys[(i * 7919) % keys.size()].id.pub_key;
+
+    flushCache();
+    auto t0 = std::chrono::steady_clock::now();
+    TEST_ASSERT_NOT_NULL(mesh.lookupContactByPubKey(key, PUB_KEY_SIZE));
+    auto t1 = std::chrono::steady_clock::now();
+    lookup_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+
+    flushCache();
+    t0 = std::chrono::steady_clock::now();
+    mesh.searchPeersByHash(key);
+    t1 = std::chrono::steady_clock::now();
+    search_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+  }
+
+  char line[100];
+  snprintf(line, sizeof(line), "contacts=%d prefix=%d  RAM/contact: index %d + record %d bytes",
+      MAX_CONTACTS, CONTACT_KEY_PREFIX_SIZE, (int)sizeof(ContactKeyRef), (int)sizeof(ContactInfo));
+  TEST_MESSAGE(line);
+  snprintf(line, sizeof(line), "cold cache: lookupContactByPubKey %.0f ns, searchPeersByHash %.0f ns", lookup_ns / N, search_ns / N);
+  TEST_MESSAGE(line);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lookup_matches_scan);
+  RUN_TEST(test_cold_lookup_time);
+  return UNITY_END();
+}
@@ -0,0 +1,156 @@
+#include <unity.h>
+#include <Dispatcher.h>
+#include <helpers/StaticPoolPacketManager.h>
+#include <helpers/HeapPacketManager.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace mesh;
+
+struct VirtualClock : public MillisecondClock {
+  unsigned long now;
+  VirtualClock() : now(0xFFFF0000UL) { }   // so tests cross the millis() wrap
+  unsigned long getMillis() override { return now; }
+};
+
+// sends take (40 + len) millis, with completion signalled by 'interrupt', ie. needsPolling()
+struct FakeRadio : public Radio {
+  VirtualClock* clock;
+  unsigned long send_done_at;
+  bool sending;
+  FakeRadio(VirtualClock* c) : clock(c), send_done_at(0), sending(false) { }
+
+  int recvRaw(uint8_t* bytes, int sz) override { return 0; }
+  uint32_t getEstAirtimeFor(int len_bytes) override { return 50 + len_bytes; }
+  float packetScore(float snr, int packet_len) override { return 0; }
+  bool startSendRaw(const uint8_t* bytes, int len) override {
+    sending = true;
+    send_done_at = clock->now + 40 + len;
+    return true;
+  }
+  bool isSendComplete() override { return sending && (long)(clock->now - send_done_at) >= 0; }
+  void onSendFinished() override { sending = false; }
+  bool isInRecvMode() const override { return !sending; }
+  bool needsPolling() const override { return isSendDue(); }
+  bool isSendDue() const { return sending && (long)(clock->now - send_done_at) >= 0; }
+};
+
+// records when each packet is received (odd) or sent (even)
+struct TestDispatcher : public Dispatcher {
+  VirtualClock* clock;
+  std::vector<unsigned long> events;
+  TestDispatcher(Radio& radio, VirtualClock& clock, PacketManager& mgr) : Dispatcher(radio, clock, mgr), clock(&clock) { }
+
+  DispatcherAction onRecvPacket(Packet* pkt) override {
+    events.push_back(clock->now * 2 + 1);
+    return ACTION_RETRANSMIT_DELAYED(1, 300);
+  }
+  void logTx(Packet* packet, int len) override { events.push_back(clock->now * 2); }
+  int getAGCResetInterval() const override { return 7000; }
+  int getInterferenceThreshold() const override { return 0; }
+};
+
+static Packet* newPacket(TestDispatcher& d, int payload_len) {
+  Packet* pkt = d.obtainNewPacket();
+  if (pkt) {
+    pkt->header = ROUTE_TYPE_FLOOD;
+    pkt->payload_len = payload_len;
+  }
+  return pkt;
+}
+
+void setUp() { }
+void tearDown() { }
+
+void test_idle_waits_until_max() {
+  VirtualClock clock;
+  FakeRadio radio(&clock);
+  StaticPoolPacketManager mgr(16);
+  TestDispatcher d(radio, clock, mgr);
+  d.begin();
+  d.loop();
+  TEST_ASSERT_EQUAL_UINT32(1000, d.getMillisToNextEvent(1000));   // AGC reset is 7 secs away
+  TEST_ASSERT_EQUAL_UINT32(7001, d.getMillisToNextEvent(60000));
+}
+
+void test_queued_send() {
+  VirtualClock clock;
+  FakeRadio radio(&clock);
+  StaticPoolPacketManager mgr(16);
+  TestDispatcher d(radio, clock, mgr);
+  d.begin();
+  d.loop();
+  d.sendPacket(newPacket(d, 10), 1, 500);
+  TEST_ASSERT_EQUAL_UINT32(500, d.getMillisToNextEvent(60000));
+
+  clock.now += 500;
+  d.loop();
+  TEST_ASSERT_TRUE(radio.sending);
+  TEST_ASSERT_EQUAL_UINT32((50 + 12) * 3 / 2 + 1, d.getMillisToNextEvent(60000));   // only the TX timeout, is 12 bytes raw
+  clock.now = radio.send_done_at;
+  TEST_ASSERT_EQUAL_UINT32(0, d.getMillisToNextEvent(60000));   // radio interrupt
+}
+
+// sleeping for getMillisToNextEvent() between calls to loop() must give exactly the same sends/receives as calling
+// loop() every millisecond
+template <class M>
+static std::vector<unsigned long> simulate(bool sleep, M& mgr) {
+  VirtualClock clock;
+  FakeRadio radio(&clock);
+  TestDispatcher d(radio, clock, mgr);
+  d.begin();
+
+  srand(42);
+  unsigned long end = clock.now + 300000;
+  unsigned long next_event = clock.now;
+  while ((long)(end - clock.now) > 0) {
+    if ((long)(clock.now - next_event) >= 0) {   // an 'external' event, ie. app sending, or packet arriving
+      Packet* pkt = newPacket(d, rand() % 100);
+      if (pkt) {
+        if (rand() & 1) {
+          d.sendPacket(pkt, rand() % 3, rand() % 5000);
+        } else {
+          mgr.queueInbound(pkt, clock.now + rand() % 3000);
+        }
+      }
+      next_event = clock.now + 100 + rand() % 4000;
+    }
+    d.loop();
+
+    uint32_t wait = 1;
+    if (sleep) {
+      wait = d.getMillisToNextEvent(1800000);
+      long to_external = (long)(next_event - clock.now);
+      if (radio.sending && (long)(radio.send_done_at - clock.now) < to_external) {
+        to_external = (long)(radio.send_done_at - clock.now);   // the radio interrupt wakes us
+      }
+      if (to_external < (long) wait) wait = to_external > 0 ? to_external : 0;
+      if (wait == 0) wait = 1;
+    }
+    clock.now += wait;
+  }
+  return d.events;
+}
+
+void test_sleep_matches_polling_static_pool() {
+  StaticPoolPacketManager a(16), b(16);
+  std::vector<unsigned long> polled = simulate(false, a);
+  TEST_ASSERT_TRUE(polled.size() > 100);
+  TEST_ASSERT_TRUE(polled == simulate(true, b));
+}
+
+void test_sleep_matches_polling_heap() {
+  HeapPacketManager a(16), b(16);
+  std::vector<unsigned long> polled = simulate(false, a);
+  TEST_ASSERT_TRUE(polled.size() > 100);
+  TEST_ASSERT_TRUE(polled == simulate(true, b));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_idle_waits_until_max);
+  RUN_TEST(test_queued_send);
+  RUN_TEST(test_sleep_matches_polling_static_pool);
+  RUN_TEST(test_sleep_matches_polling_heap);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <helpers/DutyCycleLedger.h>
+#include <stdlib.h>
+#include <vector>
+
+#define HOUR_MILLIS   3600000
+
+void setUp() { }
+void tearDown() { }
+
+void test_eu868_bands() {
+  DutyCycleLedger ledger(EU868_DUTY_CYCLE_BANDS, NUM_EU868_DUTY_CYCLE_BANDS);
+
+  TEST_ASSERT_EQUAL(4, ledger.findBand(869.525f));   // g3, the usual 'narrow' preset
+  TEST_ASSERT_EQUAL(4, ledger.findBand(869.618f));
+  TEST_ASSERT_EQUAL(2, ledger.findBand(868.1f));     // g1
+  TEST_ASSERT_EQUAL(3, ledger.findBand(868.8f));     // g2
+  TEST_ASSERT_EQUAL(-1, ledger.findBand(869.3f));    // between g2 and g3
+  TEST_ASSERT_EQUAL(-1, ledger.findBand(915.0f));
+
+  TEST_ASSERT_EQUAL_UINT32(HOUR_MILLIS / 10, ledger.getLimitMillis(4));    // 10%
+  TEST_ASSERT_EQUAL_UINT32(HOUR_MILLIS / 100, ledger.getLimitMillis(2));   // 1%
+  TEST_ASSERT_EQUAL_UINT32(HOUR_MILLIS / 1000, ledger.getLimitMillis(3));  // 0.1%
+}
+
+void test_used_millis_window() {
+  DutyCycleLedger ledger(EU868_DUTY_CYCLE_BANDS, NUM_EU868_DUTY_CYCLE_BANDS);
+
+  ledger.recordTx(2, 1000, 300);
+  ledger.recordTx(3, 2000, 100);   // other band
+  ledger.recordTx(-1, 2000, 100);  // not a limited band, ignored
+
+  TEST_ASSERT_EQUAL_UINT32(300, ledger.getUsedMillis(2, 5000));
+  TEST_ASSERT_EQUAL_UINT32(100, ledger.getUsedMillis(3, 5000));
+  TEST_ASSERT_EQUAL_UINT32(150, ledger.getUsedMillis(2, 1150));               // part way through
+  TEST_ASSERT_EQUAL_UINT32(100, ledger.getUsedMillis(2, HOUR_MILLIS + 1200));  // partly out of window
+  TEST_ASSERT_EQUAL_UINT32(0, ledger.getUsedMillis(2, HOUR_MILLIS + 1300));
+}
+
+void test_earliest_tx_time() {
+  DutyCycleLedger ledger(EU868_DUTY_CYCLE_BANDS, NUM_EU868_DUTY_CYCLE_BANDS);
+  uint32_t limit = ledger.getLimitMillis(3);   // 3600 millis per hour
+  uint32_t when;
+
+  TEST_ASSERT_TRUE(ledger.getEarliestTxTime(3, 0, 1000, when));
+  TEST_ASSERT_EQUAL_UINT32(0, when);
+  TEST_ASSERT_FALSE(ledger.getEarliestTxTime(3, 0, limit + 1, when));   // can never be sent
+
+  ledger.recordTx(3, 0, 3000);
+  TEST_ASSERT_TRUE(ledger.getEarliestTxTime(3, 3000, 600, when));
+  TEST_ASSERT_EQUAL_UINT32(3000, when);   // exactly fills the limit
+  TEST_ASSERT_TRUE(ledger.getEarliestTxTime(3, 3000, 1000, when));
+  // needs 400 millis of the first TX to have left the window ending at when + 1000
+  TEST_ASSERT_EQUAL_UINT32(HOUR_MILLIS + 400 - 1000, when);
+}
+
+static const DutyCycleBand test_bands[2] = { { 868000, 868600, 100 }, { 869400, 869650, 50 } };
+
+// random traffic, always sent at the predicted earliest time, checked against a brute force millisecond map.
+// Runs across the millis() wrap, and with a ring small enough that entries get merged.
+static void checkAgainstBruteForce(int ring_size) {
+  const uint32_t window = 20000, base = 0xFFFFF000u;
+  DutyCycleLedger ledger(test_bands, 2, ring_size, window);
+  std::vector<char> busy[2];
+  busy[0].assign(200000, 0);
+  busy[1].assign(200000, 0);
+  auto used = [&](int band, long end) {
+    long n = 0;
+    for (long t = end - (long) window; t < end; t++) {
+      if (t >= 0) n += busy[band][t];
+    }
+    return n;
+  };
+
+  srand(7);
+  long t = 0;
+  int early = 0, under = 0;
+  while (t < 150000) {
+    int band = rand() % 2;
+    uint32_t airtime = 20 + rand() % 400;
+    uint32_t when;
+    if (!ledger.getEarliestTxTime(band, base + t, airtime, when)) {
+      t += 100;
+      continue;
+    }
+    long limit = window * test_bands[band].limit_permille / 1000;
+    long d = (int32_t)(when - (base + t));
+    if (used(band, t + d + airtime) > limit - (long) airtime) early++;   // would exceed the limit
+    if ((long) ledger.getUsedMillis(band, base + t) < used(band, t)) under++;
+
+    t += d + rand() % 300;
+    for (uint32_t k = 0; k < airtime; k++) busy[band][t + k] = 1;
+    ledger.recordTx(band, base + t, airtime);
+    t += airtime;
+  }
+  TEST_ASSERT_EQUAL(0, early);
+  TEST_ASSERT_EQUAL(0, under);   // merged entries may over-estimate, never under
+}
+
+void test_matches_brute_force() {
+  checkAgainstBruteForce(256);
+}
+
+void test_merged_ring_stays_compliant() {
+  checkAgainstBruteForce(8);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_eu868_bands);
+  RUN_TEST(test_used_millis_window);
+  RUN_TEST(test_earliest_tx_time);
+  RUN_TEST(test_matches_brute_force);
+  RUN_TEST(test_merged_ring_stays_compliant);
+  return UNITY_END();
+}
@@ -0,0 +1,199 @@
+#include <unity.h>
+#include <helpers/JournalStore.h>
+#include <map>
+#include <vector>
+
+using fs::MemFlash;
+
+#define REC_SET   1
+#define REC_DEL   2
+
+// the state being persisted: key (first byte of record) -> record
+typedef std::map<uint8_t, std::vector<uint8_t>> State;
+
+struct StateLoader : public JournalVisitor {
+  State* state;
+  StateLoader(State* s) : state(s) { }
+  void onJournalRecord(uint8_t type, const uint8_t* data, int len) override {
+    if (type == REC_SET) {
+      (*state)[data[0]] = std::vector<uint8_t>(data, data + len);
+    } else if (type == REC_DEL) {
+      state->erase(data[0]);
+    }
+  }
+};
+
+struct StateSnapshot : public JournalSnapshotSource {
+  State* state;
+  StateSnapshot(State* s) : state(s) { }
+  bool writeSnapshot(JournalStore& store) override {
+    for (auto& kv : *state) {
+      if (!store.writeSnapshotRecord(REC_SET, kv.second.data(), kv.second.size())) return false;
+    }
+    return true;
+  }
+};
+
+struct Op {
+  bool del;
+  uint8_t key, val;
+};
+
+static void applyOp(State& state, const Op& op) {
+  if (op.del) {
+    state.erase(op.key);
+  } else {
+    std::vector<uint8_t> rec(152, op.val);   // same size as a contact record
+    rec[0] = op.key;
+    state[op.key] = rec;
+  }
+}
+
+// same sequence as DataStore::saveContact() / deleteContact()
+static void saveOp(JournalStore& store, State& state, const Op& op) {
+  StateSnapshot snapshot(&state);
+  applyOp(state, op);
+  if (op.del) {
+    uint8_t key[32] = { op.key };
+    if (store.needsCompact() || !store.append(REC_DEL, key, sizeof(key))) store.compact(&snapshot);
+  } else {
+    if (store.needsCompact() || !store.append(REC_SET, state[op.key].data(), state[op.key].size())) store.compact(&snapshot);
+  }
+}
+
+static State reload(fs::FS& fs, JournalStore& store) {
+  State state;
+  StateLoader loader(&state);
+  store.load(&loader);
+  return state;
+}
+
+static std::vector<Op> makeOps(int n) {
+  std::vector<Op> ops;
+  uint32_t x = 12345;
+  for (int i = 0; i < n; i++) {
+    x = x * 1103515245 + 12345;
+    ops.push_back(Op { (x >> 16) % 4 == 0, (uint8_t)((x >> 8) % 40), (uint8_t)(x >> 24) });
+  }
+  return ops;
+}
+
+void setUp() {
+  MemFlash::reset();
+}
+
+void tearDown() { }
+
+void test_load_empty() {
+  fs::FS fs;
+  JournalStore store(&fs, "/j");
+  State state;
+  StateLoader loader(&state);
+  TEST_ASSERT_FALSE(store.load(&loader));
+  TEST_ASSERT_TRUE(store.needsCompact());
+  TEST_ASSERT_FALSE(store.append(REC_SET, (const uint8_t *) "x", 1));   // nothing to append to yet
+}
+
+void test_compact_then_journal() {
+  fs::FS fs;
+  JournalStore store(&fs, "/j");
+  State state;
+  reload(fs, store);
+  for (const Op& op : makeOps(200)) saveOp(store, state, op);
+  TEST_ASSERT_EQUAL(1, (int) MemFlash::files.size());   // old generation was removed
+
+  JournalStore store2(&fs, "/j");
+  TEST_ASSERT_TRUE(state == reload(fs, store2));
+}
+
+void test_torn_tail_is_ignored() {
+  fs::FS fs;
+  JournalStore store(&fs, "/j");
+  State state;
+  reload(fs, store);
+  saveOp(store, state, Op { false, 1, 10 });
+  saveOp(store, state, Op { false, 2, 20 });
+
+  auto& data = MemFlash::files.begin()->second;
+  data.push_back(REC_SET);   // start of a record, then power lost
+  data.push_back(152);
+  data.push_back(7);
+
+  JournalStore store2(&fs, "/j");
+  TEST_ASSERT_TRUE(state == reload(fs, store2));
+  TEST_ASSERT_TRUE(store2.needsCompact());   // must not append after the torn record
+}
+
+void test_garbage_record_is_ignored() {
+  fs::FS fs;
+  JournalStore store(&fs, "/j");
+  State state;
+  reload(fs, store);
+  saveOp(store, state, Op { false, 1, 10 });
+
+  auto& data = MemFlash::files.begin()->second;
+  data.push_back(REC_SET);   // full length, but bad check (eg. flash page not fully programmed)
+  data.push_back(152);
+  data.push_back(3);
+  data.insert(data.end(), 151 + 4, 0xFF);
+
+  JournalStore store2(&fs, "/j");
+  TEST_ASSERT_TRUE(state == reload(fs, store2));
+  TEST_ASSERT_TRUE(store2.needsCompact());
+}
+
+// loses power at every possible point of a run of changes, then checks what is loaded after a reboot is either the state
+// before or after the change in progress, and that the store still works after that
+void test_power_loss_at_every_step() {
+  std::vector<Op> ops = makeOps(120);
+
+  // a full run, to get number of steps
+  {
+    fs::FS fs;
+    JournalStore store(&fs, "/j");
+    State state;
+    reload(fs, store);
+    for (const Op& op : ops) saveOp(store, state, op);
+  }
+  long total_steps = MemFlash::steps;
+
+  int failures = 0;
+  for (long budget = 0; budget <= total_steps; budget++) {
+    MemFlash::reset();
+    fs::FS fs;
+    State before, state;
+    int i = 0;
+    {
+      JournalStore store(&fs, "/j");
+      reload(fs, store);
+      MemFlash::budget = budget;
+      for (; i < (int) ops.size(); i++) {
+        before = state;
+        saveOp(store, state, ops[i]);
+        if (MemFlash::budget == 0) break;
+      }
+      MemFlash::budget = -1;   // power back on
+    }
+
+    JournalStore store(&fs, "/j");
+    State loaded = reload(fs, store);
+    if (i == (int) ops.size()) before = state;
+    if (loaded != before && loaded != state) failures++;
+
+    // carry on after the reboot: a new change must survive the next one
+    saveOp(store, loaded, Op { false, 99, (uint8_t) budget });
+    JournalStore store2(&fs, "/j");
+    if (reload(fs, store2) != loaded) failures++;
+  }
+  TEST_ASSERT_EQUAL(0, failures);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_load_empty);
+  RUN_TEST(test_compact_then_journal);
+  RUN_TEST(test_torn_tail_is_ignored);
+  RUN_TEST(test_garbage_record_is_ignored);
+  RUN_TEST(test_power_loss_at_every_step);
+  return UNITY_END();
+}
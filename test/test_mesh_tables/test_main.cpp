@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <helpers/HashedMeshTables.h>
+
+struct VirtualClock : public mesh::MillisecondClock {
+  unsigned long now;
+  VirtualClock() : now(1000) { }
+  unsigned long getMillis() override { return now; }
+};
+
+// ACKs are keyed by their CRC, and the CRC picks the slot, so these can be made to collide
+static void makeAck(mesh::Packet& pkt, uint32_t crc) {
+  pkt.header = (PAYLOAD_TYPE_ACK << PH_TYPE_SHIFT) | ROUTE_TYPE_FLOOD;
+  pkt.path_len = 0;
+  pkt.payload_len = 4;
+  memcpy(pkt.payload, &crc, 4);
+}
+
+#define CAPACITY  16
+#define SLOT(n)   (3 + (n) * CAPACITY)   // all probe from slot 3
+
+static bool seen(HashedMeshTables& tables, uint32_t crc) {
+  mesh::Packet pkt;
+  makeAck(pkt, crc);
+  return tables.hasSeen(&pkt);
+}
+
+static void clear(HashedMeshTables& tables, uint32_t crc) {
+  mesh::Packet pkt;
+  makeAck(pkt, crc);
+  tables.clear(&pkt);
+}
+
+void setUp() { }
+void tearDown() { }
+
+void test_probe_continues_past_tombstone() {
+  VirtualClock clock;
+  HashedMeshTables tables(clock, CAPACITY);
+  TEST_ASSERT_FALSE(seen(tables, SLOT(0)));
+  TEST_ASSERT_FALSE(seen(tables, SLOT(1)));
+  TEST_ASSERT_FALSE(seen(tables, SLOT(2)));
+
+  clear(tables, SLOT(1));   // leaves a tombstone in the middle of the chain
+  TEST_ASSERT_TRUE(seen(tables, SLOT(2)));
+  TEST_ASSERT_TRUE(seen(tables, SLOT(0)));
+  TEST_ASSERT_EQUAL(2, tables.getNumEntries());
+
+  TEST_ASSERT_FALSE(seen(tables, SLOT(1)));   // forgotten
+  TEST_ASSERT_TRUE(seen(tables, SLOT(1)));
+  TEST_ASSERT_EQUAL(3, tables.getNumEntries());
+}
+
+void test_tombstone_is_reused() {
+  VirtualClock clock;
+  HashedMeshTables tables(clock, CAPACITY);
+  for (int i = 0; i < 4; i++) seen(tables, SLOT(i));
+
+  clear(tables, SLOT(1));
+  TEST_ASSERT_FALSE(seen(tables, SLOT(4)));   // takes the tombstone's slot, not one past the chain
+  clear(tables, SLOT(3));
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL(i != 1 && i != 3, seen(tables, SLOT(i)));   // and no duplicate entry for SLOT(4)
+  }
+  TEST_ASSERT_EQUAL(5, tables.getNumEntries());
+  TEST_ASSERT_EQUAL_UINT32(0, tables.getNumEvicted());
+}
+
+void test_churn_does_not_fill_table() {
+  VirtualClock clock;
+  HashedMeshTables tables(clock, CAPACITY);
+  seen(tables, 12345);   // a live entry which must survive
+
+  for (uint32_t crc = 1; crc <= 5000; crc++) {   // seen, then cleared (eg. a TX failed), forever
+    clock.now++;
+    TEST_ASSERT_FALSE(seen(tables, crc * 7919));
+    clear(tables, crc * 7919);
+  }
+  TEST_ASSERT_TRUE(seen(tables, 12345));
+  TEST_ASSERT_EQUAL(1, tables.getNumEntries());
+  TEST_ASSERT_EQUAL_UINT32(0, tables.getNumEvicted());
+}
+
+void test_expired_entries_become_tombstones() {
+  VirtualClock clock;
+  HashedMeshTables tables(clock, CAPACITY, 10);   // 10 sec max age
+  seen(tables, SLOT(0));
+  seen(tables, SLOT(1));
+  clock.now += 5000;
+  seen(tables, SLOT(2));
+
+  clock.now += 5000;   // first two have expired
+  TEST_ASSERT_EQUAL(1, tables.getNumEntries());
+  TEST_ASSERT_TRUE(seen(tables, SLOT(2)));    // found past the expired ones
+  TEST_ASSERT_FALSE(seen(tables, SLOT(0)));
+  TEST_ASSERT_EQUAL(2, tables.getNumEntries());
+  TEST_ASSERT_EQUAL_UINT32(0, tables.getNumEvicted());
+}
+
+void test_full_window_evicts_least_recently_seen() {
+  VirtualClock clock;
+  HashedMeshTables tables(clock, CAPACITY);
+  for (int i = 0; i < CAPACITY; i++) {
+    clock.now += 10;
+    seen(tables, SLOT(i));
+  }
+  clock.now += 10;
+  TEST_ASSERT_TRUE(seen(tables, SLOT(0)));   // oldest, but refreshed
+
+  clock.now += 10;
+  TEST_ASSERT_FALSE(seen(tables, SLOT(CAPACITY)));
+  TEST_ASSERT_EQUAL_UINT32(1, tables.getNumEvicted());
+  TEST_ASSERT_TRUE(seen(tables, SLOT(0)));
+  TEST_ASSERT_FALSE(seen(tables, SLOT(1)));   // was the one evicted
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_probe_continues_past_tombstone);
+  RUN_TEST(test_tombstone_is_reused);
+  RUN_TEST(test_churn_does_not_fill_table);
+  RUN_TEST(test_expired_entries_become_tombstones);
+  RUN_TEST(test_full_window_evicts_least_recently_seen);
+  return UNITY_END();
+}
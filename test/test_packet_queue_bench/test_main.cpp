@@ -0,0 +1,80 @@
+#include <unity.h>
+#include <helpers/StaticPoolPacketManager.h>
+#include <helpers/HeapPacketManager.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+// PacketQueue (linear scan, StaticPoolPacketManager) vs PacketTimerQueue (heaps, HeapPacketManager), at pool sizes 16..256.
+// Checks they hand out packets in the same order, then prints the time per operation.
+
+void setUp() { }
+void tearDown() { }
+
+static const int POOL_SIZES[] = { 16, 32, 64, 128, 256 };
+
+void test_same_order() {
+  for (int size : POOL_SIZES) {
+    PacketQueue linear(size);
+    PacketTimerQueue heap(size);
+    std::vector<mesh::Packet> packets(size * 4);
+    int next_packet = 0, mismatches = 0;
+
+    srand(size);
+    uint32_t now = 0xFFFFF000u;   // crosses the millis() wrap
+    for (int i = 0; i < 50000; i++) {
+      if (rand() % 2 == 0 && linear.count() < size) {
+        mesh::Packet* pkt = &packets[next_packet++ % packets.size()];
+        uint8_t priority = rand() % 6;
+        uint32_t scheduled_for = now + rand() % 500 - 100;
+        linear.add(pkt, priority, scheduled_for);
+        heap.add(pkt, priority, scheduled_for);
+      } else {
+        if (linear.get(now) != heap.get(now)) mismatches++;
+      }
+      if (linear.countBefore(now) != heap.countBefore(now) || linear.count() != heap.count()) mismatches++;
+      now += rand() % 20;
+    }
+    TEST_ASSERT_EQUAL(0, mismatches);
+  }
+}
+
+// fills the queue with a mix of priorities and times, then drains it as the send loop does: countBefore(), then get()
+template <class Q>
+static double nanosPerOp(int size) {
+  Q queue(size);
+  mesh::Packet dummy;
+  uint32_t now = 0;
+  long ops = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < 4000000 / size; round++) {
+    for (int i = 0; i < size; i++) {
+      queue.add(&dummy, i % 5, now + i % 7);
+    }
+    now += 10;
+    for (int i = 0; i < size; i++) {
+      queue.countBefore(now);
+      queue.get(now);
+      ops++;
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+}
+
+void test_benchmark() {
+  char line[80];
+  TEST_MESSAGE("pool size   linear ns/op   heap ns/op");
+  for (int size : POOL_SIZES) {
+    snprintf(line, sizeof(line), "%9d   %12.1f   %10.1f", size, nanosPerOp<PacketQueue>(size), nanosPerOp<PacketTimerQueue>(size));
+    TEST_MESSAGE(line);
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_same_order);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}